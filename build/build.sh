@@ -408,6 +408,17 @@ build_libsdk() {
     popd >/dev/null
 }
 
+build_libsdkbench() {
+    TargetFile=${BuildBinPath}/libcfs.so
+    if [ ! -f ${TargetFile} ]; then
+        build_libsdkpre ${TargetFile}
+    fi
+    pushd $SrcPath >/dev/null
+    echo -n "build cfs-bench     "
+    ${CC:-cc} -O2 -Wall -I ${SrcPath}/client/libsdk -o ${BuildBinPath}/cfs-bench ${SrcPath}/client/libsdk/bench/cfs_bench.c -L${BuildBinPath} -lcfs -lpthread -Wl,-rpath,'$ORIGIN' && echo "success" || echo "failed"
+    popd >/dev/null
+}
+
 build_fdstore() {
     pushd $SrcPath >/dev/null
     echo -n "build fdstore "
@@ -521,6 +532,9 @@ case "$cmd" in
     "libsdk")
         build_libsdk
         ;;
+    "libsdkbench")
+        build_libsdkbench
+        ;;
     "fdstore")
         build_fdstore
         ;;
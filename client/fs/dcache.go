@@ -24,13 +24,21 @@ type DentryCache struct {
 	sync.Mutex
 	cache      map[string]uint64
 	expiration time.Time
+	valid      time.Duration
 }
 
 // NewDentryCache returns a new dentry cache.
 func NewDentryCache() *DentryCache {
+	return NewDentryCacheWithExpiration(DentryValidDuration)
+}
+
+// NewDentryCacheWithExpiration returns a new dentry cache, which is dropped
+// if no item was put for the valid duration.
+func NewDentryCacheWithExpiration(valid time.Duration) *DentryCache {
 	return &DentryCache{
 		cache:      make(map[string]uint64),
-		expiration: time.Now().Add(DentryValidDuration),
+		expiration: time.Now().Add(valid),
+		valid:      valid,
 	}
 }
 
@@ -42,7 +50,7 @@ func (dc *DentryCache) Put(name string, ino uint64) {
 	dc.Lock()
 	defer dc.Unlock()
 	dc.cache[name] = ino
-	dc.expiration = time.Now().Add(DentryValidDuration)
+	dc.expiration = time.Now().Add(dc.valid)
 }
 
 // Get gets the item from the cache based on the given key.
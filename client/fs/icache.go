@@ -40,6 +40,8 @@ type InodeCache struct {
 	lruList     *list.List
 	expiration  time.Duration
 	maxElements int
+	stopC       chan struct{}
+	stopOnce    sync.Once
 }
 
 // NewInodeCache returns a new inode cache.
@@ -49,11 +51,19 @@ func NewInodeCache(exp time.Duration, maxElements int) *InodeCache {
 		lruList:     list.New(),
 		expiration:  exp,
 		maxElements: maxElements,
+		stopC:       make(chan struct{}),
 	}
 	go ic.backgroundEviction()
 	return ic
 }
 
+// Stop stops the background eviction, the cache must not be used afterwards.
+func (ic *InodeCache) Stop() {
+	ic.stopOnce.Do(func() {
+		close(ic.stopC)
+	})
+}
+
 // Put puts the given inode info into the inode cache.
 func (ic *InodeCache) Put(info *proto.InodeInfo) {
 	ic.Lock()
@@ -168,7 +178,12 @@ func (ic *InodeCache) backgroundEviction() {
 	t := time.NewTicker(BgEvictionInterval)
 	defer t.Stop()
 
-	for range t.C {
+	for {
+		select {
+		case <-ic.stopC:
+			return
+		case <-t.C:
+		}
 		log.LogInfof("InodeCache: start BG evict")
 		if !DisableMetaCache {
 			log.LogInfof("InodeCache: no need to do BG evict")
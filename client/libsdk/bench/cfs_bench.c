@@ -0,0 +1,476 @@
+/*
+ * Copyright 2024 The CubeFS Authors.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+ * implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+/*
+ * cfs-bench runs workloads against a volume through the C API of libcfs.so.
+ *
+ * The workloads given to -w run one after another, each one in -t threads
+ * spread over -n clients, and each thread works on its own files below the
+ * directory -d, so that a workload can reuse the files of the previous one:
+ *
+ *   cfs-bench -c masterAddr=127.0.0.1:17010 -c volName=ltptest \
+ *             -c accessKey=... -c secretKey=... -w seqwrite,seqread,randread -t 8 -n 2
+ *   cfs-bench ... -w create,stat,readdir,unlink -N 100000
+ *
+ * Every -c key=value is passed to cfs_set_client. For each workload the
+ * throughput and the latency distribution of its operations are reported.
+ */
+
+#include <errno.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "libcfs.h"
+
+#define MAX_CONFIGS 64
+#define DIRENT_BATCH 1024
+
+/* latency histogram: 8 linear sub-buckets for every power of two of ns */
+#define HIST_SUB_BITS 3
+#define HIST_SUBS (1 << HIST_SUB_BITS)
+#define HIST_BUCKETS (64 * HIST_SUBS)
+
+enum workload {
+    W_SEQWRITE,
+    W_SEQREAD,
+    W_RANDWRITE,
+    W_RANDREAD,
+    W_CREATE,
+    W_STAT,
+    W_UNLINK,
+    W_READDIR,
+};
+
+static const char *workload_names[] = {
+    "seqwrite", "seqread", "randwrite", "randread",
+    "create", "stat", "unlink", "readdir",
+};
+
+#define NUM_WORKLOADS (int)(sizeof(workload_names) / sizeof(workload_names[0]))
+
+struct hist {
+    uint64_t buckets[HIST_BUCKETS];
+    uint64_t count;
+    uint64_t sum;
+    uint64_t max;
+};
+
+struct options {
+    char *configs[MAX_CONFIGS];
+    int num_configs;
+    int workloads[NUM_WORKLOADS];
+    int num_workloads;
+    char *dir;
+    int threads;
+    int clients;
+    size_t block_size;
+    size_t file_size;
+    long ops;
+    int loops;
+};
+
+struct worker {
+    pthread_t thread;
+    int id;
+    int64_t cid;
+    int workload;
+    unsigned int seed;
+    uint64_t ops;
+    uint64_t errors;
+    uint64_t bytes;
+    struct hist hist;
+};
+
+static struct options opts = {
+    .dir = "/cfs-bench",
+    .threads = 1,
+    .clients = 1,
+    .block_size = 128 * 1024,
+    .file_size = 1024 * 1024 * 1024,
+    .ops = 10000,
+    .loops = 1,
+};
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static int hist_index(uint64_t v)
+{
+    int msb;
+
+    if (v < HIST_SUBS)
+        return (int)v;
+    msb = 63 - __builtin_clzll(v);
+    return (msb - HIST_SUB_BITS + 1) * HIST_SUBS + (int)((v >> (msb - HIST_SUB_BITS)) & (HIST_SUBS - 1));
+}
+
+/* hist_value returns the upper bound of bucket i */
+static uint64_t hist_value(int i)
+{
+    int msb;
+
+    if (i < HIST_SUBS)
+        return (uint64_t)i;
+    msb = i / HIST_SUBS + HIST_SUB_BITS - 1;
+    return ((uint64_t)(HIST_SUBS + i % HIST_SUBS + 1) << (msb - HIST_SUB_BITS)) - 1;
+}
+
+static void hist_add(struct hist *h, uint64_t v)
+{
+    h->buckets[hist_index(v)]++;
+    h->count++;
+    h->sum += v;
+    if (v > h->max)
+        h->max = v;
+}
+
+static void hist_merge(struct hist *dst, const struct hist *src)
+{
+    int i;
+
+    for (i = 0; i < HIST_BUCKETS; i++)
+        dst->buckets[i] += src->buckets[i];
+    dst->count += src->count;
+    dst->sum += src->sum;
+    if (src->max > dst->max)
+        dst->max = src->max;
+}
+
+static uint64_t hist_percentile(const struct hist *h, double p)
+{
+    uint64_t rank = (uint64_t)(p / 100 * h->count), seen = 0;
+    int i;
+
+    for (i = 0; i < HIST_BUCKETS; i++) {
+        seen += h->buckets[i];
+        if (seen > rank)
+            return hist_value(i) < h->max ? hist_value(i) : h->max;
+    }
+    return h->max;
+}
+
+static void file_path(char *buf, size_t len, int thread, long i)
+{
+    if (i < 0)
+        snprintf(buf, len, "%s/t%d", opts.dir, thread);
+    else
+        snprintf(buf, len, "%s/t%d/f%ld", opts.dir, thread, i);
+}
+
+static void record(struct worker *w, uint64_t start, int64_t ret)
+{
+    hist_add(&w->hist, now_ns() - start);
+    w->ops++;
+    if (ret < 0)
+        w->errors++;
+    else
+        w->bytes += (uint64_t)ret;
+}
+
+static void run_io(struct worker *w)
+{
+    int write = w->workload == W_SEQWRITE || w->workload == W_RANDWRITE;
+    int random = w->workload == W_RANDWRITE || w->workload == W_RANDREAD;
+    long blocks = (long)(opts.file_size / opts.block_size);
+    long ops = random ? opts.ops : blocks;
+    char path[4096];
+    char *buf;
+    long i;
+    int fd;
+
+    file_path(path, sizeof(path), w->id, -1);
+    cfs_mkdirs(w->cid, path, 0755);
+    file_path(path, sizeof(path), w->id, 0);
+    fd = cfs_open(w->cid, path, write ? O_RDWR | O_CREAT : O_RDONLY, 0644);
+    if (fd < 0) {
+        fprintf(stderr, "open %s: %s\n", path, strerror(-fd));
+        w->errors++;
+        return;
+    }
+    buf = malloc(opts.block_size);
+    memset(buf, w->id, opts.block_size);
+    for (i = 0; i < ops; i++) {
+        off_t off = (off_t)(random ? rand_r(&w->seed) % blocks : i) * opts.block_size;
+        uint64_t start = now_ns();
+        ssize_t ret;
+
+        if (write)
+            ret = cfs_write(w->cid, fd, buf, opts.block_size, off);
+        else
+            ret = cfs_read(w->cid, fd, buf, opts.block_size, off);
+        record(w, start, ret);
+    }
+    if (write) {
+        int ret = cfs_flush(w->cid, fd);
+        if (ret < 0) {
+            fprintf(stderr, "flush %s: %s\n", path, strerror(-ret));
+            w->errors++;
+        }
+    }
+    cfs_close(w->cid, fd);
+    free(buf);
+}
+
+static void run_meta(struct worker *w)
+{
+    struct cfs_stat_info stat;
+    char path[4096];
+    long i;
+
+    file_path(path, sizeof(path), w->id, -1);
+    if (w->workload == W_CREATE)
+        cfs_mkdirs(w->cid, path, 0755);
+    for (i = 0; i < opts.ops; i++) {
+        uint64_t start;
+        int ret;
+
+        file_path(path, sizeof(path), w->id, i);
+        start = now_ns();
+        switch (w->workload) {
+        case W_CREATE:
+            ret = cfs_open(w->cid, path, O_WRONLY | O_CREAT, 0644);
+            if (ret >= 0) {
+                cfs_close(w->cid, ret);
+                ret = 0;
+            }
+            break;
+        case W_STAT:
+            ret = cfs_getattr(w->cid, path, &stat);
+            break;
+        default:
+            ret = cfs_unlink(w->cid, path);
+            break;
+        }
+        record(w, start, ret);
+    }
+}
+
+/* run_readdir lists the directory of the thread, an operation is a listing */
+static void run_readdir(struct worker *w)
+{
+    struct cfs_dirent *dirents = calloc(DIRENT_BATCH, sizeof(*dirents));
+    GoSlice slice = { dirents, DIRENT_BATCH, DIRENT_BATCH };
+    char path[4096];
+    int i;
+
+    file_path(path, sizeof(path), w->id, -1);
+    for (i = 0; i < opts.loops; i++) {
+        uint64_t start = now_ns();
+        int64_t entries = 0;
+        int fd, n;
+
+        fd = cfs_open(w->cid, path, O_RDONLY, 0);
+        if (fd < 0) {
+            record(w, start, fd);
+            continue;
+        }
+        while ((n = cfs_readdir(w->cid, fd, slice, DIRENT_BATCH)) > 0)
+            entries += n;
+        cfs_close(w->cid, fd);
+        record(w, start, n < 0 ? n : entries);
+    }
+    free(dirents);
+}
+
+static void *worker_main(void *arg)
+{
+    struct worker *w = arg;
+
+    switch (w->workload) {
+    case W_SEQWRITE:
+    case W_SEQREAD:
+    case W_RANDWRITE:
+    case W_RANDREAD:
+        run_io(w);
+        break;
+    case W_READDIR:
+        run_readdir(w);
+        break;
+    default:
+        run_meta(w);
+        break;
+    }
+    return NULL;
+}
+
+static void report(int workload, struct worker *workers, double secs)
+{
+    struct hist total;
+    uint64_t ops = 0, errors = 0, bytes = 0;
+    int i;
+
+    memset(&total, 0, sizeof(total));
+    for (i = 0; i < opts.threads; i++) {
+        hist_merge(&total, &workers[i].hist);
+        ops += workers[i].ops;
+        errors += workers[i].errors;
+        bytes += workers[i].bytes;
+    }
+    printf("%-10s ops %llu errors %llu time %.3fs %.1f ops/s", workload_names[workload],
+           (unsigned long long)ops, (unsigned long long)errors, secs, ops / secs);
+    if (workload == W_READDIR)
+        printf(" %.1f entries/s", bytes / secs);
+    else if (workload <= W_RANDREAD)
+        printf(" %.2f MB/s", bytes / secs / (1024 * 1024));
+    printf("\n");
+    if (total.count == 0)
+        return;
+    printf("%-10s lat(us) avg %.1f p50 %.1f p90 %.1f p99 %.1f p99.9 %.1f max %.1f\n", "",
+           total.sum / 1000.0 / total.count,
+           hist_percentile(&total, 50) / 1000.0, hist_percentile(&total, 90) / 1000.0,
+           hist_percentile(&total, 99) / 1000.0, hist_percentile(&total, 99.9) / 1000.0,
+           total.max / 1000.0);
+}
+
+static int64_t new_client(void)
+{
+    int64_t cid = cfs_new_client();
+    int i, ret;
+
+    for (i = 0; i < opts.num_configs; i++) {
+        char *key = opts.configs[i], *val = strchr(key, '=');
+
+        *val = '\0';
+        ret = cfs_set_client(cid, key, val + 1);
+        *val = '=';
+        if (ret < 0) {
+            fprintf(stderr, "set %s: %s\n", key, strerror(-ret));
+            exit(1);
+        }
+    }
+    ret = cfs_start_client(cid);
+    if (ret < 0) {
+        fprintf(stderr, "start client: %s\n", strerror(-ret));
+        exit(1);
+    }
+    return cid;
+}
+
+static void parse_workloads(char *arg)
+{
+    char *name;
+    int i;
+
+    for (name = strtok(arg, ","); name; name = strtok(NULL, ",")) {
+        for (i = 0; i < NUM_WORKLOADS; i++)
+            if (strcmp(name, workload_names[i]) == 0)
+                break;
+        if (i == NUM_WORKLOADS || opts.num_workloads == NUM_WORKLOADS) {
+            fprintf(stderr, "invalid workload %s\n", name);
+            exit(1);
+        }
+        opts.workloads[opts.num_workloads++] = i;
+    }
+}
+
+static size_t parse_size(const char *arg)
+{
+    char *end;
+    size_t v = strtoull(arg, &end, 10);
+
+    switch (*end) {
+    case 'g': case 'G': v <<= 10; /* fallthrough */
+    case 'm': case 'M': v <<= 10; /* fallthrough */
+    case 'k': case 'K': v <<= 10;
+    }
+    return v;
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "usage: %s -c key=value... -w workload[,workload...] [options]\n"
+            "  -c key=value  client setting, e.g. masterAddr, volName, logDir\n"
+            "  -w workloads  seqwrite, seqread, randwrite, randread,\n"
+            "                create, stat, unlink, readdir\n"
+            "  -d dir        working directory (default %s)\n"
+            "  -t threads    threads (default %d)\n"
+            "  -n clients    clients shared by the threads (default %d)\n"
+            "  -b size       io size (default %zu)\n"
+            "  -f size       file size of each thread (default %zu)\n"
+            "  -N ops        random ios or files of each thread (default %ld)\n"
+            "  -l loops      listings of each thread for readdir (default %d)\n",
+            prog, opts.dir, opts.threads, opts.clients, opts.block_size, opts.file_size,
+            opts.ops, opts.loops);
+    exit(1);
+}
+
+int main(int argc, char **argv)
+{
+    struct worker *workers;
+    int64_t *clients;
+    int c, i, j;
+
+    while ((c = getopt(argc, argv, "c:w:d:t:n:b:f:N:l:h")) != -1) {
+        switch (c) {
+        case 'c':
+            if (!strchr(optarg, '=') || opts.num_configs == MAX_CONFIGS)
+                usage(argv[0]);
+            opts.configs[opts.num_configs++] = optarg;
+            break;
+        case 'w': parse_workloads(optarg); break;
+        case 'd': opts.dir = optarg; break;
+        case 't': opts.threads = atoi(optarg); break;
+        case 'n': opts.clients = atoi(optarg); break;
+        case 'b': opts.block_size = parse_size(optarg); break;
+        case 'f': opts.file_size = parse_size(optarg); break;
+        case 'N': opts.ops = atol(optarg); break;
+        case 'l': opts.loops = atoi(optarg); break;
+        default: usage(argv[0]);
+        }
+    }
+    if (opts.num_workloads == 0 || opts.threads <= 0 || opts.clients <= 0 ||
+        opts.block_size == 0 || opts.file_size < opts.block_size)
+        usage(argv[0]);
+    if (opts.clients > opts.threads)
+        opts.clients = opts.threads;
+
+    clients = calloc(opts.clients, sizeof(*clients));
+    for (i = 0; i < opts.clients; i++)
+        clients[i] = new_client();
+    workers = calloc(opts.threads, sizeof(*workers));
+
+    for (j = 0; j < opts.num_workloads; j++) {
+        uint64_t start;
+
+        memset(workers, 0, opts.threads * sizeof(*workers));
+        start = now_ns();
+        for (i = 0; i < opts.threads; i++) {
+            workers[i].id = i;
+            workers[i].cid = clients[i % opts.clients];
+            workers[i].workload = opts.workloads[j];
+            workers[i].seed = (unsigned int)(start + i);
+            pthread_create(&workers[i].thread, NULL, worker_main, &workers[i]);
+        }
+        for (i = 0; i < opts.threads; i++)
+            pthread_join(workers[i].thread, NULL);
+        report(opts.workloads[j], workers, (now_ns() - start) / 1e9);
+    }
+
+    for (i = 0; i < opts.clients; i++)
+        cfs_close_client(clients[i]);
+    free(workers);
+    free(clients);
+    return 0;
+}
@@ -0,0 +1,113 @@
+// Copyright 2024 The CubeFS Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+
+package main
+
+import (
+	"github.com/cubefs/cubefs/proto"
+)
+
+const dirStreamPageSize = 1024
+
+type readDirLimitFunc func(parentID uint64, from string, limit uint64) ([]proto.Dentry, error)
+
+type dirPage struct {
+	dentries []proto.Dentry
+	err      error
+}
+
+// dirStream pages through a directory with ReadDirLimit_ll, so that only a
+// page or two of entries are held at any time, whatever the directory size.
+// The next page is fetched in the background while the current one is
+// consumed.
+type dirStream struct {
+	ino          uint64
+	readDirLimit readDirLimitFunc
+
+	pos     int
+	dirents []proto.Dentry // current page
+	last    string         // name of the last entry read from the directory
+	eof     bool           // no page after the current one
+	next    chan dirPage   // prefetch of the next page, nil if none in flight
+}
+
+func newDirStream(ino uint64, readDirLimit readDirLimitFunc) *dirStream {
+	return &dirStream{
+		ino:          ino,
+		readDirLimit: readDirLimit,
+	}
+}
+
+// entry returns the entry at the cursor, or nil at the end of the directory.
+func (d *dirStream) entry() (*proto.Dentry, error) {
+	for d.pos >= len(d.dirents) {
+		if d.eof {
+			return nil, nil
+		}
+		var page dirPage
+		if d.next != nil {
+			page = <-d.next
+			d.next = nil
+		} else {
+			page = d.fetch(d.last)
+		}
+		if page.err != nil {
+			// the page is fetched again on the next call
+			return nil, page.err
+		}
+		d.setPage(page.dentries)
+	}
+	return &d.dirents[d.pos], nil
+}
+
+func (d *dirStream) advance() {
+	d.pos++
+}
+
+func (d *dirStream) setPage(dentries []proto.Dentry) {
+	d.pos = 0
+	d.dirents = dentries
+	if len(dentries) < dirStreamPageSize {
+		d.eof = true
+		return
+	}
+	d.last = dentries[len(dentries)-1].Name
+	next := make(chan dirPage, 1)
+	d.next = next
+	from := d.last
+	go func() {
+		next <- d.fetch(from)
+	}()
+}
+
+// fetch reads the page following the entry named from, the first page if
+// from is empty.
+func (d *dirStream) fetch(from string) dirPage {
+	if from == "" {
+		dentries, err := d.readDirLimit(d.ino, "", dirStreamPageSize)
+		return dirPage{dentries: dentries, err: err}
+	}
+	// from is included in the result
+	dentries, err := d.readDirLimit(d.ino, from, dirStreamPageSize+1)
+	if err != nil {
+		return dirPage{err: err}
+	}
+	if len(dentries) > 0 && dentries[0].Name == from {
+		dentries = dentries[1:]
+	} else if len(dentries) > dirStreamPageSize {
+		// from was removed meanwhile
+		dentries = dentries[:dirStreamPageSize]
+	}
+	return dirPage{dentries: dentries}
+}
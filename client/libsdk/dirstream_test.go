@@ -0,0 +1,86 @@
+// Copyright 2024 The CubeFS Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+
+package main
+
+import (
+	"fmt"
+	"sort"
+	"syscall"
+	"testing"
+
+	"github.com/cubefs/cubefs/proto"
+	"github.com/stretchr/testify/require"
+)
+
+// fakeReadDirLimit behaves like ReadDirLimit_ll on a directory of n entries,
+// from is included in the result.
+func fakeReadDirLimit(n int) readDirLimitFunc {
+	names := make([]string, n)
+	for i := range names {
+		names[i] = fmt.Sprintf("f%08d", i)
+	}
+	return func(parentID uint64, from string, limit uint64) ([]proto.Dentry, error) {
+		i := sort.SearchStrings(names, from)
+		var dentries []proto.Dentry
+		for ; i < len(names) && uint64(len(dentries)) < limit; i++ {
+			dentries = append(dentries, proto.Dentry{Name: names[i], Inode: uint64(i + 1)})
+		}
+		return dentries, nil
+	}
+}
+
+func TestDirStream(t *testing.T) {
+	for _, n := range []int{0, 1, dirStreamPageSize - 1, dirStreamPageSize, 3*dirStreamPageSize + 7} {
+		d := newDirStream(1, fakeReadDirLimit(n))
+		count := 0
+		for {
+			dentry, err := d.entry()
+			require.NoError(t, err)
+			if dentry == nil {
+				break
+			}
+			require.Equal(t, fmt.Sprintf("f%08d", count), dentry.Name)
+			d.advance()
+			count++
+		}
+		require.Equal(t, n, count)
+	}
+}
+
+func TestDirStreamError(t *testing.T) {
+	readDirLimit := fakeReadDirLimit(2 * dirStreamPageSize)
+	fail := true
+	d := newDirStream(1, func(parentID uint64, from string, limit uint64) ([]proto.Dentry, error) {
+		if from != "" && fail {
+			return nil, syscall.EIO
+		}
+		return readDirLimit(parentID, from, limit)
+	})
+
+	for i := 0; i < dirStreamPageSize; i++ {
+		dentry, err := d.entry()
+		require.NoError(t, err)
+		require.NotNil(t, dentry)
+		d.advance()
+	}
+	_, err := d.entry()
+	require.Equal(t, syscall.EIO, err)
+
+	// the failed page is fetched again
+	fail = false
+	dentry, err := d.entry()
+	require.NoError(t, err)
+	require.Equal(t, fmt.Sprintf("f%08d", dirStreamPageSize), dentry.Name)
+}
@@ -0,0 +1,143 @@
+// Copyright 2024 The CubeFS Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+
+package main
+
+import (
+	"sync"
+	"sync/atomic"
+	"unsafe"
+
+	"github.com/bits-and-blooms/bitset"
+)
+
+const (
+	fdChunkBits = 12
+	fdChunkSize = 1 << fdChunkBits
+	fdChunkMask = fdChunkSize - 1
+)
+
+type fdChunk [fdChunkSize]unsafe.Pointer // *file
+
+// fdTable maps fds to opened files. Lookups are lock free: the files are kept
+// in lazily allocated chunks which are published with atomic stores, so the
+// read/write path never touches the lock. Allocation and release of fds are
+// serialized by the lock, and always return the lowest free fd.
+type fdTable struct {
+	maxFd  uint
+	chunks []unsafe.Pointer // *fdChunk
+
+	sync.Mutex
+	fdset *bitset.BitSet
+	next  uint // every fd below next is in use
+}
+
+func newFDTable(maxFd uint) *fdTable {
+	return &fdTable{
+		maxFd:  maxFd,
+		chunks: make([]unsafe.Pointer, maxFd/fdChunkSize+1),
+		fdset:  bitset.New(maxFd + 1),
+	}
+}
+
+// reserve marks the given fds as used, so that they are never allocated.
+func (t *fdTable) reserve(fds ...uint) {
+	t.Lock()
+	defer t.Unlock()
+	for _, fd := range fds {
+		t.fdset.Set(fd)
+	}
+	t.next, _ = t.fdset.NextClear(0)
+}
+
+// alloc returns the lowest free fd. The fd is not visible to get until a
+// file is installed with store.
+func (t *fdTable) alloc() (fd uint, ok bool) {
+	t.Lock()
+	defer t.Unlock()
+	fd, ok = t.fdset.NextClear(t.next)
+	if !ok || fd > t.maxFd {
+		return 0, false
+	}
+	t.fdset.Set(fd)
+	t.next = fd + 1
+	return fd, true
+}
+
+func (t *fdTable) store(fd uint, f *file) {
+	chunk := t.chunk(fd)
+	if chunk == nil {
+		t.Lock()
+		if chunk = t.chunk(fd); chunk == nil {
+			chunk = new(fdChunk)
+			atomic.StorePointer(&t.chunks[fd>>fdChunkBits], unsafe.Pointer(chunk))
+		}
+		t.Unlock()
+	}
+	atomic.StorePointer(&chunk[fd&fdChunkMask], unsafe.Pointer(f))
+}
+
+func (t *fdTable) get(fd uint) *file {
+	if fd > t.maxFd {
+		return nil
+	}
+	chunk := t.chunk(fd)
+	if chunk == nil {
+		return nil
+	}
+	return (*file)(atomic.LoadPointer(&chunk[fd&fdChunkMask]))
+}
+
+// release removes the file of fd from the table and frees the fd.
+// It returns nil if fd is not opened.
+func (t *fdTable) release(fd uint) *file {
+	if fd > t.maxFd {
+		return nil
+	}
+	t.Lock()
+	defer t.Unlock()
+	chunk := t.chunk(fd)
+	if chunk == nil {
+		return nil
+	}
+	f := (*file)(atomic.SwapPointer(&chunk[fd&fdChunkMask], nil))
+	if f == nil {
+		return nil
+	}
+	t.fdset.Clear(fd)
+	if fd < t.next {
+		t.next = fd
+	}
+	return f
+}
+
+// files returns the opened files.
+func (t *fdTable) files() (files []*file) {
+	for i := range t.chunks {
+		chunk := (*fdChunk)(atomic.LoadPointer(&t.chunks[i]))
+		if chunk == nil {
+			continue
+		}
+		for j := range chunk {
+			if f := (*file)(atomic.LoadPointer(&chunk[j])); f != nil {
+				files = append(files, f)
+			}
+		}
+	}
+	return
+}
+
+func (t *fdTable) chunk(fd uint) *fdChunk {
+	return (*fdChunk)(atomic.LoadPointer(&t.chunks[fd>>fdChunkBits]))
+}
@@ -0,0 +1,111 @@
+// Copyright 2024 The CubeFS Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+
+package main
+
+import (
+	"sync"
+	"testing"
+
+	"github.com/stretchr/testify/require"
+)
+
+func TestFDTable(t *testing.T) {
+	table := newFDTable(fdChunkSize * 2)
+	table.reserve(0, 1, 2)
+
+	for i := uint(3); i < fdChunkSize+10; i++ {
+		fd, ok := table.alloc()
+		require.True(t, ok)
+		require.Equal(t, i, fd)
+		require.Nil(t, table.get(fd))
+		table.store(fd, &file{fd: fd})
+		require.Equal(t, fd, table.get(fd).fd)
+	}
+
+	require.Equal(t, uint(5), table.release(5).fd)
+	require.Nil(t, table.release(5))
+	require.Nil(t, table.get(5))
+	require.Equal(t, uint(fdChunkSize+1), table.release(fdChunkSize+1).fd)
+
+	files := table.files()
+	require.Len(t, files, fdChunkSize+10-3-2)
+	for _, f := range files {
+		require.Equal(t, f, table.get(f.fd))
+	}
+
+	// the lowest free fd is always allocated first
+	fd, ok := table.alloc()
+	require.True(t, ok)
+	require.Equal(t, uint(5), fd)
+	fd, ok = table.alloc()
+	require.True(t, ok)
+	require.Equal(t, uint(fdChunkSize+1), fd)
+
+	require.Nil(t, table.get(fdChunkSize*4))
+	require.Nil(t, table.release(fdChunkSize*4))
+}
+
+func TestFDTableExhausted(t *testing.T) {
+	table := newFDTable(3)
+	table.reserve(0, 1, 2)
+	fd, ok := table.alloc()
+	require.True(t, ok)
+	require.Equal(t, uint(3), fd)
+	_, ok = table.alloc()
+	require.False(t, ok)
+}
+
+const benchOpenFiles = 1024
+
+// Run with -cpu 1,4,16,64 to compare how lookups scale with the number of threads.
+func BenchmarkFDTableGet(b *testing.B) {
+	table := newFDTable(maxFdNum)
+	for i := 0; i < benchOpenFiles; i++ {
+		fd, _ := table.alloc()
+		table.store(fd, &file{fd: fd})
+	}
+	b.ResetTimer()
+	b.RunParallel(func(pb *testing.PB) {
+		fd := uint(0)
+		for pb.Next() {
+			if f := table.get(fd % benchOpenFiles); f == nil {
+				b.Fatal("file not found")
+			}
+			fd++
+		}
+	})
+}
+
+// BenchmarkFDMapGet is the former fdmap guarded by fdlock, kept as a baseline.
+func BenchmarkFDMapGet(b *testing.B) {
+	var lock sync.RWMutex
+	fdmap := make(map[uint]*file)
+	for i := uint(0); i < benchOpenFiles; i++ {
+		fdmap[i] = &file{fd: i}
+	}
+	b.ResetTimer()
+	b.RunParallel(func(pb *testing.PB) {
+		fd := uint(0)
+		for pb.Next() {
+			lock.Lock()
+			f := fdmap[fd%benchOpenFiles]
+			lock.Unlock()
+			if f == nil {
+				b.Fatal("file not found")
+			}
+			fd++
+		}
+	})
+}
@@ -29,6 +29,7 @@ typedef struct { const char *p; ptrdiff_t n; } _GoString_;
 #include <sys/stat.h>
 #include <dirent.h>
 #include <fcntl.h>
+#include <sys/uio.h>
 
 struct cfs_stat_info {
     uint64_t ino;
@@ -99,6 +100,37 @@ struct cfs_access_file_info {
     char accessFileSizeBlobStore[256];
 };
 
+struct cfs_io_req {
+    int      fd;
+    off_t    off;
+    size_t   size;
+    void*    buf;
+    ssize_t  ret;
+};
+
+#define CFS_AIO_READ  0
+#define CFS_AIO_WRITE 1
+#define CFS_AIO_FSYNC 2
+
+struct cfs_aio_req {
+    int      opcode;
+    int      fd;
+    off_t    off;
+    size_t   size;
+    void*    buf;
+    uint64_t user_data;
+};
+
+struct cfs_aio_event {
+    uint64_t user_data;
+    ssize_t  res;
+};
+
+// With writeBehindFlushMs set, cfs_write returns once the data is buffered.
+// cfs_close and cfs_close_client write out the buffered data of the fds, but
+// can't report an error: call cfs_flush before closing an fd to know whether
+// its writes have reached the data nodes.
+
 
 #line 1 "cgo-generated-wrapper"
 
@@ -154,15 +186,27 @@ extern int64_t cfs_new_client();
 extern int cfs_set_client(int64_t id, char* key, char* val);
 extern int cfs_start_client(int64_t id);
 extern void cfs_close_client(int64_t id);
+extern int cfs_get_stats(int64_t id, char* buf, int size);
 extern int cfs_chdir(int64_t id, char* path);
 extern char* cfs_getcwd(int64_t id);
 extern int cfs_getattr(int64_t id, char* path, struct cfs_stat_info* stat);
+extern int cfs_stat_paths(int64_t id, char** paths, int count, struct cfs_stat_info* stats, int* results);
 extern int cfs_setattr(int64_t id, char* path, struct cfs_stat_info* stat, int valid);
 extern int cfs_open(int64_t id, char* path, int flags, mode_t mode);
 extern int cfs_flush(int64_t id, int fd);
 extern void cfs_close(int64_t id, int fd);
 extern ssize_t cfs_write(int64_t id, int fd, void* buf, size_t size, off_t off);
+extern ssize_t cfs_writev(int64_t id, int fd, struct iovec* iov, int iovcnt, off_t off);
 extern ssize_t cfs_read(int64_t id, int fd, void* buf, size_t size, off_t off);
+extern int cfs_mmap_ro(int64_t id, int fd, void** addr, size_t* length);
+extern int cfs_mmap_prefetch(int64_t id, int fd, off_t off, size_t size);
+extern int cfs_munmap(int64_t id, int fd);
+extern ssize_t cfs_readv(int64_t id, int fd, struct iovec* iov, int iovcnt, off_t off);
+extern int cfs_pread_batch(int64_t id, struct cfs_io_req* reqs, int count);
+extern int cfs_aio_setup(int64_t id, int depth, int efd);
+extern int cfs_aio_destroy(int64_t id);
+extern int cfs_aio_submit(int64_t id, struct cfs_aio_req* reqs, int count);
+extern int cfs_aio_getevents(int64_t id, struct cfs_aio_event* events, int min_nr, int max_nr, int64_t timeout_ms);
 extern int cfs_batch_get_inodes(int64_t id, int fd, void* iids, GoSlice stats, int count);
 extern int cfs_refreshsummary(int64_t id, char* path, int goroutine_num, char* unit ,char* split);
 extern int cfs_readdir(int64_t id, int fd, GoSlice dirents, int count);
@@ -23,6 +23,7 @@ package main
 #include <sys/stat.h>
 #include <dirent.h>
 #include <fcntl.h>
+#include <sys/uio.h>
 
 struct cfs_stat_info {
     uint64_t ino;
@@ -93,6 +94,37 @@ struct cfs_access_file_info {
     char accessFileSizeBlobStore[256];
 };
 
+struct cfs_io_req {
+    int      fd;
+    off_t    off;
+    size_t   size;
+    void*    buf;
+    ssize_t  ret;
+};
+
+#define CFS_AIO_READ  0
+#define CFS_AIO_WRITE 1
+#define CFS_AIO_FSYNC 2
+
+struct cfs_aio_req {
+    int      opcode;
+    int      fd;
+    off_t    off;
+    size_t   size;
+    void*    buf;
+    uint64_t user_data;
+};
+
+struct cfs_aio_event {
+    uint64_t user_data;
+    ssize_t  res;
+};
+
+// With writeBehindFlushMs set, cfs_write returns once the data is buffered.
+// cfs_close and cfs_close_client write out the buffered data of the fds, but
+// can't report an error: call cfs_flush before closing an fd to know whether
+// its writes have reached the data nodes.
+
 */
 import "C"
 
@@ -101,6 +133,7 @@ import (
 	"fmt"
 	"io"
 	syslog "log"
+	"net/http"
 	"os"
 	"path"
 	gopath "path"
@@ -114,7 +147,6 @@ import (
 	"time"
 	"unsafe"
 
-	"github.com/bits-and-blooms/bitset"
 	"github.com/cubefs/cubefs/blobstore/api/access"
 	"github.com/cubefs/cubefs/blobstore/common/trace"
 	"github.com/cubefs/cubefs/client/blockcache/bcache"
@@ -127,6 +159,7 @@ import (
 	"github.com/cubefs/cubefs/util/auditlog"
 	"github.com/cubefs/cubefs/util/buf"
 	"github.com/cubefs/cubefs/util/errors"
+	"github.com/cubefs/cubefs/util/exporter"
 	"github.com/cubefs/cubefs/util/log"
 	"github.com/cubefs/cubefs/util/stat"
 )
@@ -137,6 +170,13 @@ const (
 	maxFdNum uint = 10240000
 
 	MaxSizePutOnce = int64(1) << 23
+
+	// max number of in-flight requests of a single batch call, such as
+	// cfs_pread_batch and cfs_stat_paths
+	maxBatchIOConcurrency = 32
+
+	// max number of pages of inodes fetched at once by cfs_lsdir
+	maxLsdirInflightPages = 4
 )
 
 var gClientManager *clientManager
@@ -154,6 +194,7 @@ var (
 	statusEISDIR  = errorToStatus(syscall.EISDIR)
 	statusENOSPC  = errorToStatus(syscall.ENOSPC)
 	statusEPERM   = errorToStatus(syscall.EPERM)
+	statusEAGAIN  = errorToStatus(syscall.EAGAIN)
 )
 
 var once sync.Once
@@ -184,13 +225,12 @@ func newClient() *client {
 	id := atomic.AddInt64(&gClientManager.nextClientID, 1)
 	c := &client{
 		id:                  id,
-		fdmap:               make(map[uint]*file),
-		fdset:               bitset.New(maxFdNum),
+		fds:                 newFDTable(maxFdNum),
+		stats:               &opStats{},
 		dirChildrenNumLimit: proto.DefaultDirChildrenNumLimit,
 		cwd:                 "/",
-		sc:                  fs.NewSummaryCache(fs.DefaultSummaryExpiration, fs.MaxSummaryCache),
-		ic:                  fs.NewInodeCache(fs.DefaultInodeExpiration, fs.MaxInodeCache),
-		dc:                  fs.NewDentryCache(),
+		mappings:            make(map[uint64]*roMapping),
+		writeBehinds:        make(map[uint64]*writeBehind),
 	}
 
 	gClientManager.mu.Lock()
@@ -226,15 +266,15 @@ type file struct {
 	// rw
 	fileWriter *blobstore.Writer
 	fileReader *blobstore.Reader
+	ctx        context.Context // trace context of the blobstore calls
 
 	path         string
 	storageClass uint32
 	openForWrite bool
-}
 
-type dirStream struct {
-	pos     int
-	dirents []proto.Dentry
+	wb    *writeBehind // of the inode, nil if the writes are not buffered
+	mmap  *roMapping   // set by cfs_mmap_ro, guarded by client.mu
+	mmaps int          // cfs_mmap_ro calls on the fd not yet undone
 }
 
 type client struct {
@@ -269,12 +309,24 @@ type client struct {
 	volAllowedStorageClass []uint32
 	cacheDpStorageClass    uint32
 	enableInnerReq         bool
+	readAheadMemMB         int64
+	readAheadWindowMB      int64
+	readPipelineDepth      int
+	hedgeReadPercentile    int
+	metaCacheCfg           metaCacheConfig
+	pathCacheTimeout       time.Duration
+	pathCacheMaxEntries    int
+	writeBehindDelay       time.Duration
+	shareMetaCache         bool
+	statsAddr              string
 
 	// runtime context
-	cwd    string // current working directory
-	fdmap  map[uint]*file
-	fdset  *bitset.BitSet
-	fdlock sync.RWMutex
+	cwd   string       // current working directory
+	aio   atomic.Value // *aioContext, set by cfs_aio_setup and cleared by cfs_aio_destroy
+	fds   *fdTable
+	stats *opStats
+
+	statsServer *http.Server // serves stats at statsAddr
 
 	// server info
 	mw   *meta.MetaWrapper
@@ -283,8 +335,18 @@ type client struct {
 	dc   *fs.DentryCache
 	bc   *bcache.BcacheClient
 	ebsc *blobstore.BlobStoreClient
-	sc   *fs.SummaryCache
+	sc   *summaryTree
+	nc   *negDentryCache
 	mu   sync.Mutex
+
+	mappings map[uint64]*roMapping // by inode, guarded by mu
+
+	// not guarded by mu, lookupPath writes them out with mu held
+	wbMu         sync.Mutex
+	writeBehinds map[uint64]*writeBehind // by inode, guarded by wbMu
+
+	metaCache          *metaCache // of ic, dc, sc and nc, nil once released
+	sharedMetaCacheKey string     // set if the metadata caches are shared
 }
 
 //export cfs_get_xattr
@@ -298,6 +360,7 @@ func cfs_get_xattr(id C.int64_t, path *C.char, key *C.char) *C.char {
 		log.LogErrorf("cfs_get_xattr path(%v) key(%v) failed, client not exist", dstPath, xattrKey)
 		return C.CString("")
 	}
+	defer c.stats.done(opGetXattr, time.Now())
 
 	info, err := c.lookupPath(c.absPath(dstPath))
 	if err != nil {
@@ -328,6 +391,7 @@ func cfs_get_accessFiles(id C.int64_t, path *C.char, depth C.int, goroutine_num
 		log.LogErrorf("cfs_get_accessFiles path(%v) failed, client not exist", dstPath)
 		return -1
 	}
+	defer c.stats.done(opGetAccessFiles, time.Now())
 
 	inodeInfo, err := c.lookupPath(c.absPath(dstPath))
 	if err != nil {
@@ -364,6 +428,7 @@ func cfs_list_vols(id C.int64_t, volsInfo []C.struct_cfs_vol_info, count C.int)
 	if !exist {
 		return statusEINVAL
 	}
+	defer c.stats.done(opListVols, time.Now())
 
 	vols, err := c.mw.ListVols("")
 	if err != nil {
@@ -411,6 +476,7 @@ func cfs_symlink(id C.int64_t, src_path *C.char, dst_path *C.char) C.int {
 	if !exist {
 		return statusEINVAL
 	}
+	defer c.stats.done(opSymlink, time.Now())
 
 	fullSrcPath := c.absPath(C.GoString(src_path))
 	fullDstPath := c.absPath(C.GoString(dst_path))
@@ -429,7 +495,9 @@ func cfs_symlink(id C.int64_t, src_path *C.char, dst_path *C.char) C.int {
 		return errorToStatus(err)
 	}
 
+	c.nc.Delete(fullDstPath)
 	c.ic.Put(info)
+	c.sc.Add(parent_dir, summaryDelta(info, false))
 	log.LogDebugf("Symlink: src_path(%s) dst_path(%s)\n", fullSrcPath, fullDstPath)
 
 	return statusOK
@@ -441,6 +509,7 @@ func cfs_link(id C.int64_t, src_path *C.char, dst_path *C.char) C.int {
 	if !exist {
 		return statusEINVAL
 	}
+	defer c.stats.done(opLink, time.Now())
 
 	fullSrcPath := c.absPath(C.GoString(src_path))
 	info, err := c.lookupPath(fullSrcPath)
@@ -469,7 +538,9 @@ func cfs_link(id C.int64_t, src_path *C.char, dst_path *C.char) C.int {
 		return errorToStatus(err)
 	}
 
+	c.nc.Delete(fullDstPath)
 	c.ic.Put(info)
+	c.sc.Invalidate(parent_dir)
 	log.LogDebugf("Link: src_path(%s) src_ino(%v) dst_path(%s) dst_ino(%v) parent(%v)\n", fullSrcPath, src_ino, fullDstPath, info.Inode, parentIno)
 
 	return statusOK
@@ -481,6 +552,7 @@ func cfs_get_dir_lock(id C.int64_t, path *C.char, lock_id *C.int64_t, valid_time
 	if !exist {
 		return statusEINVAL
 	}
+	defer c.stats.done(opGetDirLock, time.Now())
 	c.mu.Lock()
 	defer c.mu.Unlock()
 
@@ -519,6 +591,7 @@ func cfs_lock_dir(id C.int64_t, path *C.char, lease C.uint64_t, lockId C.int64_t
 	if !exist {
 		return C.int64_t(statusEINVAL)
 	}
+	defer c.stats.done(opLockDir, time.Now())
 	c.mu.Lock()
 	defer c.mu.Unlock()
 
@@ -549,6 +622,7 @@ func cfs_unlock_dir(id C.int64_t, path *C.char) C.int {
 	if !exist {
 		return statusEINVAL
 	}
+	defer c.stats.done(opUnlockDir, time.Now())
 
 	c.mu.Lock()
 	defer c.mu.Unlock()
@@ -571,7 +645,7 @@ func cfs_unlock_dir(id C.int64_t, path *C.char) C.int {
 func cfs_new_client() C.int64_t {
 	c := newClient()
 	// Just skip fd 0, 1, 2, to avoid confusion.
-	c.fdset.Set(0).Set(1).Set(2)
+	c.fds.reserve(0, 1, 2)
 	return C.int64_t(c.id)
 }
 
@@ -639,6 +713,84 @@ func cfs_set_client(id C.int64_t, key, val *C.char) C.int {
 		} else {
 			c.enableInnerReq = false
 		}
+	case "readAheadMemMB":
+		mb, err := strconv.ParseInt(v, 10, 64)
+		if err == nil {
+			c.readAheadMemMB = mb
+		}
+	case "readAheadWindowMB":
+		mb, err := strconv.ParseInt(v, 10, 64)
+		if err == nil {
+			c.readAheadWindowMB = mb
+		}
+	case "readPipelineDepth":
+		depth, err := strconv.Atoi(v)
+		if err == nil {
+			c.readPipelineDepth = depth
+		}
+	case "hedgeReadPercentile":
+		percentile, err := strconv.Atoi(v)
+		if err == nil {
+			c.hedgeReadPercentile = percentile
+		}
+	case "icacheTimeout":
+		sec, err := strconv.ParseInt(v, 10, 64)
+		if err == nil {
+			c.metaCacheCfg.icacheTimeout = time.Duration(sec) * time.Second
+		}
+	case "icacheMaxEntries":
+		entries, err := strconv.Atoi(v)
+		if err == nil {
+			c.metaCacheCfg.icacheMaxEntries = entries
+		}
+	case "dcacheTimeout":
+		sec, err := strconv.ParseInt(v, 10, 64)
+		if err == nil {
+			c.metaCacheCfg.dcacheTimeout = time.Duration(sec) * time.Second
+		}
+	case "scacheTimeout":
+		sec, err := strconv.ParseInt(v, 10, 64)
+		if err == nil {
+			c.metaCacheCfg.scacheTimeout = time.Duration(sec) * time.Second
+		}
+	case "scacheMaxEntries":
+		entries, err := strconv.Atoi(v)
+		if err == nil {
+			c.metaCacheCfg.scacheMaxEntries = entries
+		}
+	case "negDcacheTimeoutMs":
+		ms, err := strconv.ParseInt(v, 10, 64)
+		if err == nil {
+			c.metaCacheCfg.negDcacheTimeout = time.Duration(ms) * time.Millisecond
+		}
+	case "negDcacheMaxEntries":
+		entries, err := strconv.Atoi(v)
+		if err == nil {
+			c.metaCacheCfg.negDcacheMaxEntries = entries
+		}
+	case "pathCacheTimeout":
+		sec, err := strconv.ParseInt(v, 10, 64)
+		if err == nil {
+			c.pathCacheTimeout = time.Duration(sec) * time.Second
+		}
+	case "pathCacheMaxEntries":
+		entries, err := strconv.Atoi(v)
+		if err == nil {
+			c.pathCacheMaxEntries = entries
+		}
+	case "writeBehindFlushMs":
+		ms, err := strconv.ParseInt(v, 10, 64)
+		if err == nil {
+			c.writeBehindDelay = time.Duration(ms) * time.Millisecond
+		}
+	case "statsAddr":
+		c.statsAddr = v
+	case "shareMetaCache":
+		if v == "true" {
+			c.shareMetaCache = true
+		} else {
+			c.shareMetaCache = false
+		}
 	default:
 		return statusEINVAL
 	}
@@ -663,24 +815,61 @@ func cfs_start_client(id C.int64_t) C.int {
 //export cfs_close_client
 func cfs_close_client(id C.int64_t) {
 	if c, exist := getClient(int64(id)); exist {
+		c.releaseMappings()
+		// the requests in progress use ec
+		_ = c.destroyAio()
 		if c.ec != nil {
+			c.flushOpenFiles()
 			_ = c.ec.Close()
 		}
 		if c.mw != nil {
 			_ = c.mw.Close()
 		}
+		c.releaseMetaCache()
+		if c.statsServer != nil {
+			_ = c.statsServer.Close()
+		}
 		removeClient(int64(id))
 	}
 	auditlog.StopAudit()
 	log.LogFlush()
 }
 
+/*
+ * cfs_get_stats writes the latency statistics of the calls of the client
+ * to buf, a line per call with its count and latency percentiles in
+ * microseconds. Like snprintf, it writes at most size bytes including the
+ * terminating null byte, and returns the length of the whole statistics.
+ */
+
+//export cfs_get_stats
+func cfs_get_stats(id C.int64_t, buf *C.char, size C.int) C.int {
+	c, exist := getClient(int64(id))
+	if !exist {
+		return statusEINVAL
+	}
+
+	var sb strings.Builder
+	c.stats.writeText(&sb)
+	if size > 0 {
+		var buffer []byte
+		hdr := (*reflect.SliceHeader)(unsafe.Pointer(&buffer))
+		hdr.Data = uintptr(unsafe.Pointer(buf))
+		hdr.Len = int(size)
+		hdr.Cap = int(size)
+		n := copy(buffer[:len(buffer)-1], sb.String())
+		buffer[n] = 0
+	}
+	return C.int(sb.Len())
+}
+
 //export cfs_chdir
 func cfs_chdir(id C.int64_t, path *C.char) C.int {
 	c, exist := getClient(int64(id))
 	if !exist {
 		return statusEINVAL
 	}
+	defer c.stats.done(opChdir, time.Now())
 	cwd := c.absPath(C.GoString(path))
 	dirInfo, err := c.lookupPath(cwd)
 	if err != nil {
@@ -699,6 +888,7 @@ func cfs_getcwd(id C.int64_t) *C.char {
 	if !exist {
 		return C.CString("")
 	}
+	defer c.stats.done(opGetcwd, time.Now())
 	return C.CString(c.cwd)
 }
 
@@ -708,49 +898,67 @@ func cfs_getattr(id C.int64_t, path *C.char, stat *C.struct_cfs_stat_info) C.int
 	if !exist {
 		return statusEINVAL
 	}
+	defer c.stats.done(opGetattr, time.Now())
 
 	info, err := c.lookupPath(c.absPath(C.GoString(path)))
 	if err != nil {
 		return errorToStatus(err)
 	}
 
-	// fill up the stat
-	stat.ino = C.uint64_t(info.Inode)
-	stat.size = C.uint64_t(info.Size)
-	stat.nlink = C.uint32_t(info.Nlink)
-	stat.blk_size = C.uint32_t(defaultBlkSize)
-	stat.uid = C.uint32_t(info.Uid)
-	stat.gid = C.uint32_t(info.Gid)
+	fillStatInfo(info, stat)
+	return statusOK
+}
 
-	if info.Size%512 != 0 {
-		stat.blocks = C.uint64_t(info.Size>>9) + 1
-	} else {
-		stat.blocks = C.uint64_t(info.Size >> 9)
+/*
+ * cfs_stat_paths stats count paths at once. The parent directories shared
+ * by the paths are resolved once, and the inodes are fetched in batches
+ * per meta partition. The status of each path, 0 or a negative errno, is
+ * stored in results.
+ */
+
+//export cfs_stat_paths
+func cfs_stat_paths(id C.int64_t, paths **C.char, count C.int, stats *C.struct_cfs_stat_info, results *C.int) C.int {
+	c, exist := getClient(int64(id))
+	if !exist {
+		return statusEINVAL
 	}
-	// fill up the mode
-	if proto.IsRegular(info.Mode) {
-		stat.mode = C.uint32_t(C.S_IFREG) | C.uint32_t(info.Mode&0o777)
-	} else if proto.IsDir(info.Mode) {
-		stat.mode = C.uint32_t(C.S_IFDIR) | C.uint32_t(info.Mode&0o777)
-	} else if proto.IsSymlink(info.Mode) {
-		stat.mode = C.uint32_t(C.S_IFLNK) | C.uint32_t(info.Mode&0o777)
-	} else {
-		stat.mode = C.uint32_t(C.S_IFSOCK) | C.uint32_t(info.Mode&0o777)
+	defer c.stats.done(opStatPaths, time.Now())
+	if count <= 0 {
+		return statusOK
 	}
 
-	// fill up the time struct
-	t := info.AccessTime.UnixNano()
-	stat.atime = C.uint64_t(t / 1e9)
-	stat.atime_nsec = C.uint32_t(t % 1e9)
+	var cpaths []*C.char
+	hdr := (*reflect.SliceHeader)(unsafe.Pointer(&cpaths))
+	hdr.Data = uintptr(unsafe.Pointer(paths))
+	hdr.Len = int(count)
+	hdr.Cap = int(count)
 
-	t = info.ModifyTime.UnixNano()
-	stat.mtime = C.uint64_t(t / 1e9)
-	stat.mtime_nsec = C.uint32_t(t % 1e9)
+	var statList []C.struct_cfs_stat_info
+	hdr = (*reflect.SliceHeader)(unsafe.Pointer(&statList))
+	hdr.Data = uintptr(unsafe.Pointer(stats))
+	hdr.Len = int(count)
+	hdr.Cap = int(count)
 
-	t = info.CreateTime.UnixNano()
-	stat.ctime = C.uint64_t(t / 1e9)
-	stat.ctime_nsec = C.uint32_t(t % 1e9)
+	var statuses []C.int
+	hdr = (*reflect.SliceHeader)(unsafe.Pointer(&statuses))
+	hdr.Data = uintptr(unsafe.Pointer(results))
+	hdr.Len = int(count)
+	hdr.Cap = int(count)
 
+	absPaths := make([]string, count)
+	for i, p := range cpaths {
+		absPaths[i] = c.absPath(C.GoString(p))
+	}
+
+	infos, errs := c.statPaths(absPaths)
+	for i := range absPaths {
+		if errs[i] != nil {
+			statuses[i] = errorToStatus(errs[i])
+			continue
+		}
+		fillStatInfo(infos[i], &statList[i])
+		statuses[i] = statusOK
+	}
 	return statusOK
 }
 
@@ -760,6 +968,7 @@ func cfs_setattr(id C.int64_t, path *C.char, stat *C.struct_cfs_stat_info, valid
 	if !exist {
 		return statusEINVAL
 	}
+	defer c.stats.done(opSetattr, time.Now())
 
 	info, err := c.lookupPath(c.absPath(C.GoString(path)))
 	if err != nil {
@@ -781,6 +990,7 @@ func cfs_open(id C.int64_t, path *C.char, flags C.int, mode C.mode_t) C.int {
 	if !exist {
 		return statusEINVAL
 	}
+	defer c.stats.done(opOpen, time.Now())
 	start := time.Now()
 
 	fuseMode := uint32(mode) & uint32(0o777)
@@ -851,6 +1061,7 @@ func cfs_open(id C.int64_t, path *C.char, flags C.int, mode C.mode_t) C.int {
 
 	if proto.IsRegular(info.Mode) {
 		c.openStream(f)
+		c.setupWriteBehind(f)
 		if fuseFlags&uint32(C.O_TRUNC) != 0 {
 			if accFlags != uint32(C.O_WRONLY) && accFlags != uint32(C.O_RDWR) {
 				c.closeStream(f)
@@ -874,6 +1085,7 @@ func cfs_flush(id C.int64_t, fd C.int) C.int {
 	if !exist {
 		return statusEINVAL
 	}
+	defer c.stats.done(opFlush, time.Now())
 
 	f := c.getFile(uint(fd))
 	if f == nil {
@@ -894,6 +1106,7 @@ func cfs_close(id C.int64_t, fd C.int) {
 	if !exist {
 		return
 	}
+	defer c.stats.done(opClose, time.Now())
 
 	f := c.getFile(uint(fd))
 	if f == nil {
@@ -906,10 +1119,23 @@ func cfs_close(id C.int64_t, fd C.int) {
 	}
 
 	f = c.releaseFD(uint(fd))
-	// Consistent with cfs open, do close and closeStream only if f is regular file
-	if f != nil && info != nil && proto.IsRegular(info.Mode) {
-		c.flush(f)
+	if f == nil {
+		return
+	}
+	c.munmap(f, true)
+	// Consistent with cfs open, do close and closeStream only if f is regular
+	// file. A file with buffered writes is one even if its inode could not be
+	// fetched, and its writes are written out anyway. The flush errors can't
+	// be returned, cfs_flush reports them.
+	if f.wb != nil || (info != nil && proto.IsRegular(info.Mode)) {
+		if err := c.flush(f); err != nil {
+			log.LogErrorf("cfs_close: flush ino(%v) fd(%v) err(%v)", f.ino, fd, err)
+		}
 		c.closeStream(f)
+		if f.openForWrite {
+			// the file size may have changed
+			c.sc.Invalidate(gopath.Dir(f.path))
+		}
 	}
 }
 
@@ -919,6 +1145,7 @@ func cfs_truncate(id C.int64_t, fd C.int, size C.size_t) C.int {
 	if !exist {
 		return statusEINVAL
 	}
+	defer c.stats.done(opTruncate, time.Now())
 	f := c.getFile(uint(fd))
 	if f == nil {
 		return statusEBADFD
@@ -935,6 +1162,7 @@ func cfs_write(id C.int64_t, fd C.int, buf unsafe.Pointer, size C.size_t, off C.
 	if !exist {
 		return C.ssize_t(statusEINVAL)
 	}
+	defer c.stats.done(opWrite, time.Now())
 
 	f := c.getFile(uint(fd))
 	if f == nil {
@@ -953,18 +1181,7 @@ func cfs_write(id C.int64_t, fd C.int, buf unsafe.Pointer, size C.size_t, off C.
 	hdr.Len = int(size)
 	hdr.Cap = int(size)
 
-	var flags int
-	var wait bool
-
-	if f.flags&uint32(C.O_DIRECT) != 0 || f.flags&uint32(C.O_SYNC) != 0 || f.flags&uint32(C.O_DSYNC) != 0 {
-		if proto.IsHot(c.volType) || proto.IsStorageClassReplica(f.storageClass) {
-			wait = true
-		}
-	}
-	if f.flags&uint32(C.O_APPEND) != 0 || proto.IsCold(c.volType) || proto.IsStorageClassBlobStore(f.storageClass) {
-		flags |= proto.FlagsAppend
-		flags |= proto.FlagsSyncWrite
-	}
+	flags, wait := c.writeFlags(f)
 
 	n, err := c.write(f, int(off), buffer, flags)
 	if err != nil {
@@ -983,12 +1200,67 @@ func cfs_write(id C.int64_t, fd C.int, buf unsafe.Pointer, size C.size_t, off C.
 	return C.ssize_t(n)
 }
 
+//export cfs_writev
+func cfs_writev(id C.int64_t, fd C.int, iov *C.struct_iovec, iovcnt C.int, off C.off_t) C.ssize_t {
+	c, exist := getClient(int64(id))
+	if !exist {
+		return C.ssize_t(statusEINVAL)
+	}
+	defer c.stats.done(opWritev, time.Now())
+
+	f := c.getFile(uint(fd))
+	if f == nil {
+		return C.ssize_t(statusEBADFD)
+	}
+
+	accFlags := f.flags & uint32(C.O_ACCMODE)
+	if accFlags != uint32(C.O_WRONLY) && accFlags != uint32(C.O_RDWR) {
+		return C.ssize_t(statusEACCES)
+	}
+
+	flags, wait := c.writeFlags(f)
+
+	// Write every buffer back to back, and flush only once at the end
+	// if the file is opened with O_SYNC/O_DSYNC/O_DIRECT.
+	total := 0
+	offset := int(off)
+	for _, vec := range iovecSlice(iov, iovcnt) {
+		if vec.iov_len == 0 {
+			continue
+		}
+		n, err := c.write(f, offset, goBytes(vec.iov_base, vec.iov_len), flags)
+		if err != nil {
+			if total > 0 {
+				break
+			}
+			if err == syscall.ENOSPC {
+				return C.ssize_t(statusENOSPC)
+			}
+			return C.ssize_t(statusEIO)
+		}
+		total += n
+		offset += n
+		if n < int(vec.iov_len) {
+			break
+		}
+	}
+
+	if wait && total > 0 {
+		if err := c.flush(f); err != nil {
+			return C.ssize_t(statusEIO)
+		}
+	}
+
+	return C.ssize_t(total)
+}
+
 //export cfs_read
 func cfs_read(id C.int64_t, fd C.int, buf unsafe.Pointer, size C.size_t, off C.off_t) C.ssize_t {
 	c, exist := getClient(int64(id))
 	if !exist {
 		return C.ssize_t(statusEINVAL)
 	}
+	defer c.stats.done(opRead, time.Now())
 
 	f := c.getFile(uint(fd))
 	if f == nil {
@@ -1015,145 +1287,495 @@ func cfs_read(id C.int64_t, fd C.int, buf unsafe.Pointer, size C.size_t, off C.o
 	return C.ssize_t(n)
 }
 
-//export cfs_batch_get_inodes
-func cfs_batch_get_inodes(id C.int64_t, fd C.int, iids unsafe.Pointer, stats []C.struct_cfs_stat_info, count C.int) (n C.int) {
+/*
+ * cfs_mmap_ro maps the file of fd, which must be opened read only, into
+ * memory, and stores the address and the length of the mapping in addr and
+ * length. The length is the file size at the first call, and an empty file
+ * is mapped to NULL.
+ *
+ * The mapping is loaded explicitly: the pages are readable once
+ * cfs_mmap_prefetch has loaded them, and touching any other page raises
+ * SIGSEGV. Loaded pages are plain memory, shared by all the threads reading
+ * the mapping. Mapping the same file again, through any fd of the client,
+ * returns the same memory while it's mapped. The mapping of an fd is
+ * released by the matching number of cfs_munmap calls, or when fd is
+ * closed, and the memory once no fd maps it, or when the client is closed.
+ */
+
+//export cfs_mmap_ro
+func cfs_mmap_ro(id C.int64_t, fd C.int, addr *unsafe.Pointer, length *C.size_t) C.int {
 	c, exist := getClient(int64(id))
 	if !exist {
 		return statusEINVAL
 	}
+	defer c.stats.done(opMmapRO, time.Now())
 
 	f := c.getFile(uint(fd))
 	if f == nil {
 		return statusEBADFD
 	}
-
-	var inodeIDS []uint64
-
-	hdr := (*reflect.SliceHeader)(unsafe.Pointer(&inodeIDS))
-	hdr.Data = uintptr(iids)
-	hdr.Len = int(count)
-	hdr.Cap = int(count)
-
-	infos := c.mw.BatchInodeGet(inodeIDS)
-	if len(infos) > int(count) {
-		return statusEINVAL
+	if f.flags&uint32(C.O_ACCMODE) != uint32(C.O_RDONLY) {
+		return statusEACCES
 	}
 
-	for i := 0; i < len(infos); i++ {
-		// fill up the stat
-		stats[i].ino = C.uint64_t(infos[i].Inode)
-		stats[i].size = C.uint64_t(infos[i].Size)
-		stats[i].blocks = C.uint64_t(infos[i].Size >> 9)
-		stats[i].nlink = C.uint32_t(infos[i].Nlink)
-		stats[i].blk_size = C.uint32_t(defaultBlkSize)
-		stats[i].uid = C.uint32_t(infos[i].Uid)
-		stats[i].gid = C.uint32_t(infos[i].Gid)
-
-		// fill up the mode
-		if proto.IsRegular(infos[i].Mode) {
-			stats[i].mode = C.uint32_t(C.S_IFREG) | C.uint32_t(infos[i].Mode&0o777)
-		} else if proto.IsDir(infos[i].Mode) {
-			stats[i].mode = C.uint32_t(C.S_IFDIR) | C.uint32_t(infos[i].Mode&0o777)
-		} else if proto.IsSymlink(infos[i].Mode) {
-			stats[i].mode = C.uint32_t(C.S_IFLNK) | C.uint32_t(infos[i].Mode&0o777)
-		} else {
-			stats[i].mode = C.uint32_t(C.S_IFSOCK) | C.uint32_t(infos[i].Mode&0o777)
-		}
-
-		// fill up the time struct
-		t := infos[i].AccessTime.UnixNano()
-		stats[i].atime = C.uint64_t(t / 1e9)
-		stats[i].atime_nsec = C.uint32_t(t % 1e9)
-
-		t = infos[i].ModifyTime.UnixNano()
-		stats[i].mtime = C.uint64_t(t / 1e9)
-		stats[i].mtime_nsec = C.uint32_t(t % 1e9)
-
-		t = infos[i].CreateTime.UnixNano()
-		stats[i].ctime = C.uint64_t(t / 1e9)
-		stats[i].ctime_nsec = C.uint32_t(t % 1e9)
+	m, err := c.mmapRO(f)
+	if err != nil {
+		return errorToStatus(err)
 	}
-
-	n = C.int(len(infos))
-	return
+	if m == nil {
+		*addr = nil
+		*length = 0
+		return statusOK
+	}
+	*addr = unsafe.Pointer(&m.data[0])
+	*length = C.size_t(m.size)
+	return statusOK
 }
 
-//export cfs_refreshsummary
-func cfs_refreshsummary(id C.int64_t, path *C.char, goroutine_num C.int, unit *C.char, split *C.char) C.int {
+/*
+ * cfs_mmap_prefetch loads the range [off, off+size) of the mapping of fd
+ * and makes it readable. It returns once the whole range is readable,
+ * including the parts loaded meanwhile by other calls.
+ */
+
+//export cfs_mmap_prefetch
+func cfs_mmap_prefetch(id C.int64_t, fd C.int, off C.off_t, size C.size_t) C.int {
 	c, exist := getClient(int64(id))
 	if !exist {
 		return statusEINVAL
 	}
-	if !c.enableSummary {
-		return statusEINVAL
+	defer c.stats.done(opMmapPrefetch, time.Now())
+
+	f := c.getFile(uint(fd))
+	if f == nil {
+		return statusEBADFD
 	}
-	info, err := c.lookupPath(c.absPath(C.GoString(path)))
-	var ino uint64
-	if err != nil {
-		ino = proto.RootIno
-	} else {
-		ino = info.Inode
+	m := c.getMapping(f)
+	if m == nil {
+		return statusEINVAL
 	}
-	goroutineNum := int32(goroutine_num)
-	err = c.mw.RefreshSummary_ll(ino, goroutineNum, C.GoString(unit), C.GoString(split))
-	if err != nil {
+	defer c.putMapping(m)
+
+	if err := m.prefetch(int(off), int(size), maxBatchIOConcurrency); err != nil {
 		return errorToStatus(err)
 	}
 	return statusOK
 }
 
-/*
- * Note that readdir is not thread-safe according to the POSIX spec.
- */
-
-//export cfs_readdir
-func cfs_readdir(id C.int64_t, fd C.int, dirents []C.struct_cfs_dirent, count C.int) (n C.int) {
+//export cfs_munmap
+func cfs_munmap(id C.int64_t, fd C.int) C.int {
 	c, exist := getClient(int64(id))
 	if !exist {
 		return statusEINVAL
 	}
+	defer c.stats.done(opMunmap, time.Now())
 
 	f := c.getFile(uint(fd))
 	if f == nil {
 		return statusEBADFD
 	}
+	if !c.munmap(f, false) {
+		return statusEINVAL
+	}
+	return statusOK
+}
 
-	if f.dirp == nil {
-		f.dirp = &dirStream{}
-		dentries, err := c.mw.ReadDir_ll(f.ino)
-		if err != nil {
-			return errorToStatus(err)
-		}
-		f.dirp.dirents = dentries
+//export cfs_readv
+func cfs_readv(id C.int64_t, fd C.int, iov *C.struct_iovec, iovcnt C.int, off C.off_t) C.ssize_t {
+	c, exist := getClient(int64(id))
+	if !exist {
+		return C.ssize_t(statusEINVAL)
 	}
+	defer c.stats.done(opReadv, time.Now())
 
-	dirp := f.dirp
-	for dirp.pos < len(dirp.dirents) && n < count {
-		// fill up ino
-		dirents[n].ino = C.uint64_t(dirp.dirents[dirp.pos].Inode)
+	f := c.getFile(uint(fd))
+	if f == nil {
+		return C.ssize_t(statusEBADFD)
+	}
 
-		// fill up d_type
-		if proto.IsRegular(dirp.dirents[dirp.pos].Type) {
-			dirents[n].d_type = C.DT_REG
-		} else if proto.IsDir(dirp.dirents[dirp.pos].Type) {
+	accFlags := f.flags & uint32(C.O_ACCMODE)
+	if accFlags == uint32(C.O_WRONLY) {
+		return C.ssize_t(statusEACCES)
+	}
+
+	vecs := iovecSlice(iov, iovcnt)
+	bufs := make([][]byte, len(vecs))
+	for i, vec := range vecs {
+		bufs[i] = goBytes(vec.iov_base, vec.iov_len)
+	}
+	total, err := readVectors(bufs, int(off), func(offset int, data []byte) (int, error) {
+		return c.read(f, offset, data)
+	})
+	if err != nil {
+		return C.ssize_t(statusEIO)
+	}
+	return C.ssize_t(total)
+}
+
+// readVectors reads the buffers in order from offset with read, and returns
+// the number of bytes read. An error is only returned if nothing was read.
+func readVectors(bufs [][]byte, offset int, read func(offset int, data []byte) (int, error)) (int, error) {
+	total := 0
+	for _, buf := range bufs {
+		if len(buf) == 0 {
+			continue
+		}
+		n, err := read(offset, buf)
+		if err != nil {
+			if total > 0 {
+				break
+			}
+			return 0, err
+		}
+		total += n
+		offset += n
+		// short read means EOF, the remaining buffers are left untouched
+		if n < len(buf) {
+			break
+		}
+	}
+	return total, nil
+}
+
+/*
+ * cfs_pread_batch reads every request concurrently, and stores the number of
+ * bytes read (or a negative errno) in the ret field of each request.
+ * It returns the number of requests that succeeded.
+ */
+
+//export cfs_pread_batch
+func cfs_pread_batch(id C.int64_t, reqs *C.struct_cfs_io_req, count C.int) C.int {
+	c, exist := getClient(int64(id))
+	if !exist {
+		return statusEINVAL
+	}
+	defer c.stats.done(opPreadBatch, time.Now())
+	if count <= 0 {
+		return 0
+	}
+
+	var ioReqs []C.struct_cfs_io_req
+	hdr := (*reflect.SliceHeader)(unsafe.Pointer(&ioReqs))
+	hdr.Data = uintptr(unsafe.Pointer(reqs))
+	hdr.Len = int(count)
+	hdr.Cap = int(count)
+
+	batch := make([]preadReq, len(ioReqs))
+	for i, req := range ioReqs {
+		batch[i] = preadReq{fd: uint(req.fd), offset: int(req.off), data: goBytes(req.buf, req.size)}
+	}
+	succeeded := c.preadBatch(batch, c.read)
+	for i := range ioReqs {
+		ioReqs[i].ret = C.ssize_t(batch[i].ret)
+	}
+	return C.int(succeeded)
+}
+
+// preadReq is a request of cfs_pread_batch.
+type preadReq struct {
+	fd     uint
+	offset int
+	data   []byte
+	ret    int // bytes read or negative errno
+}
+
+// preadBatch reads the requests concurrently with read, sets their ret and
+// returns the number of requests that succeeded.
+func (c *client) preadBatch(reqs []preadReq, read func(f *file, offset int, data []byte) (int, error)) int {
+	var (
+		wg        sync.WaitGroup
+		succeeded int32
+	)
+	limit := make(chan struct{}, maxBatchIOConcurrency)
+	for i := range reqs {
+		req := &reqs[i]
+		f := c.getFile(req.fd)
+		if f == nil {
+			req.ret = int(statusEBADFD)
+			continue
+		}
+		if f.flags&uint32(C.O_ACCMODE) == uint32(C.O_WRONLY) {
+			req.ret = int(statusEACCES)
+			continue
+		}
+		if len(req.data) == 0 {
+			req.ret = 0
+			atomic.AddInt32(&succeeded, 1)
+			continue
+		}
+
+		wg.Add(1)
+		limit <- struct{}{}
+		go func(f *file, req *preadReq) {
+			defer func() {
+				<-limit
+				wg.Done()
+			}()
+			n, err := read(f, req.offset, req.data)
+			if err != nil {
+				log.LogErrorf("cfs_pread_batch: ino(%v) offset(%v) size(%v) err(%v)", f.ino, req.offset, len(req.data), err)
+				req.ret = int(statusEIO)
+				return
+			}
+			req.ret = n
+			atomic.AddInt32(&succeeded, 1)
+		}(f, req)
+	}
+	wg.Wait()
+	return int(succeeded)
+}
+
+/*
+ * Asynchronous I/O, similar to io_setup/io_submit/io_getevents/io_destroy.
+ * The buffers of the submitted requests must stay valid until the
+ * corresponding events are reaped. cfs_aio_destroy, and cfs_close_client,
+ * wait for the requests in progress and drop the events not reaped, after
+ * which the eventfd is no longer notified.
+ */
+
+//export cfs_aio_setup
+func cfs_aio_setup(id C.int64_t, depth C.int, efd C.int) C.int {
+	c, exist := getClient(int64(id))
+	if !exist {
+		return statusEINVAL
+	}
+	defer c.stats.done(opAioSetup, time.Now())
+	return errorToStatus(c.setupAio(int(depth), int(efd)))
+}
+
+//export cfs_aio_destroy
+func cfs_aio_destroy(id C.int64_t) C.int {
+	c, exist := getClient(int64(id))
+	if !exist {
+		return statusEINVAL
+	}
+	defer c.stats.done(opAioDestroy, time.Now())
+	return errorToStatus(c.destroyAio())
+}
+
+//export cfs_aio_submit
+func cfs_aio_submit(id C.int64_t, reqs *C.struct_cfs_aio_req, count C.int) C.int {
+	c, exist := getClient(int64(id))
+	if !exist {
+		return statusEINVAL
+	}
+	defer c.stats.done(opAioSubmit, time.Now())
+	ctx := c.aioContext()
+	if ctx == nil {
+		return statusEINVAL
+	}
+	if count <= 0 {
+		return 0
+	}
+
+	var aioReqs []C.struct_cfs_aio_req
+	hdr := (*reflect.SliceHeader)(unsafe.Pointer(&aioReqs))
+	hdr.Data = uintptr(unsafe.Pointer(reqs))
+	hdr.Len = int(count)
+	hdr.Cap = int(count)
+
+	var n C.int
+	for i := range aioReqs {
+		// copy the request, the caller may reuse the submission array
+		req := aioReqs[i]
+		if !ctx.submit(uint64(req.user_data), func() int64 { return c.aioExecute(&req) }) {
+			break
+		}
+		n++
+	}
+
+	if n == 0 {
+		return statusEAGAIN
+	}
+	return n
+}
+
+//export cfs_aio_getevents
+func cfs_aio_getevents(id C.int64_t, events *C.struct_cfs_aio_event, min_nr C.int, max_nr C.int, timeout_ms C.int64_t) C.int {
+	c, exist := getClient(int64(id))
+	if !exist {
+		return statusEINVAL
+	}
+	defer c.stats.done(opAioGetevents, time.Now())
+	ctx := c.aioContext()
+	if ctx == nil {
+		return statusEINVAL
+	}
+	if max_nr <= 0 || min_nr > max_nr {
+		return statusEINVAL
+	}
+
+	var aioEvents []C.struct_cfs_aio_event
+	hdr := (*reflect.SliceHeader)(unsafe.Pointer(&aioEvents))
+	hdr.Data = uintptr(unsafe.Pointer(events))
+	hdr.Len = int(max_nr)
+	hdr.Cap = int(max_nr)
+
+	timeout := time.Duration(-1)
+	if timeout_ms >= 0 {
+		timeout = time.Duration(timeout_ms) * time.Millisecond
+	}
+	n, err := ctx.getEvents(int(min_nr), int(max_nr), timeout, func(i int, ev aioEvent) {
+		aioEvents[i].user_data = C.uint64_t(ev.userData)
+		aioEvents[i].res = C.ssize_t(ev.res)
+	})
+	if err != nil {
+		return errorToStatus(err)
+	}
+	return C.int(n)
+}
+
+//export cfs_batch_get_inodes
+func cfs_batch_get_inodes(id C.int64_t, fd C.int, iids unsafe.Pointer, stats []C.struct_cfs_stat_info, count C.int) (n C.int) {
+	c, exist := getClient(int64(id))
+	if !exist {
+		return statusEINVAL
+	}
+	defer c.stats.done(opBatchGetInodes, time.Now())
+
+	f := c.getFile(uint(fd))
+	if f == nil {
+		return statusEBADFD
+	}
+
+	var inodeIDS []uint64
+
+	hdr := (*reflect.SliceHeader)(unsafe.Pointer(&inodeIDS))
+	hdr.Data = uintptr(iids)
+	hdr.Len = int(count)
+	hdr.Cap = int(count)
+
+	for _, ino := range inodeIDS {
+		c.writeOut(ino)
+	}
+	infos := c.mw.BatchInodeGet(inodeIDS)
+	if len(infos) > int(count) {
+		return statusEINVAL
+	}
+
+	for i := 0; i < len(infos); i++ {
+		// fill up the stat
+		stats[i].ino = C.uint64_t(infos[i].Inode)
+		stats[i].size = C.uint64_t(infos[i].Size)
+		stats[i].blocks = C.uint64_t(infos[i].Size >> 9)
+		stats[i].nlink = C.uint32_t(infos[i].Nlink)
+		stats[i].blk_size = C.uint32_t(defaultBlkSize)
+		stats[i].uid = C.uint32_t(infos[i].Uid)
+		stats[i].gid = C.uint32_t(infos[i].Gid)
+
+		// fill up the mode
+		if proto.IsRegular(infos[i].Mode) {
+			stats[i].mode = C.uint32_t(C.S_IFREG) | C.uint32_t(infos[i].Mode&0o777)
+		} else if proto.IsDir(infos[i].Mode) {
+			stats[i].mode = C.uint32_t(C.S_IFDIR) | C.uint32_t(infos[i].Mode&0o777)
+		} else if proto.IsSymlink(infos[i].Mode) {
+			stats[i].mode = C.uint32_t(C.S_IFLNK) | C.uint32_t(infos[i].Mode&0o777)
+		} else {
+			stats[i].mode = C.uint32_t(C.S_IFSOCK) | C.uint32_t(infos[i].Mode&0o777)
+		}
+
+		// fill up the time struct
+		t := infos[i].AccessTime.UnixNano()
+		stats[i].atime = C.uint64_t(t / 1e9)
+		stats[i].atime_nsec = C.uint32_t(t % 1e9)
+
+		t = infos[i].ModifyTime.UnixNano()
+		stats[i].mtime = C.uint64_t(t / 1e9)
+		stats[i].mtime_nsec = C.uint32_t(t % 1e9)
+
+		t = infos[i].CreateTime.UnixNano()
+		stats[i].ctime = C.uint64_t(t / 1e9)
+		stats[i].ctime_nsec = C.uint32_t(t % 1e9)
+	}
+
+	n = C.int(len(infos))
+	return
+}
+
+//export cfs_refreshsummary
+func cfs_refreshsummary(id C.int64_t, path *C.char, goroutine_num C.int, unit *C.char, split *C.char) C.int {
+	c, exist := getClient(int64(id))
+	if !exist {
+		return statusEINVAL
+	}
+	defer c.stats.done(opRefreshSummary, time.Now())
+	if !c.enableSummary {
+		return statusEINVAL
+	}
+	info, err := c.lookupPath(c.absPath(C.GoString(path)))
+	var ino uint64
+	if err != nil {
+		ino = proto.RootIno
+	} else {
+		ino = info.Inode
+	}
+	goroutineNum := int32(goroutine_num)
+	err = c.mw.RefreshSummary_ll(ino, goroutineNum, C.GoString(unit), C.GoString(split))
+	if err != nil {
+		return errorToStatus(err)
+	}
+	return statusOK
+}
+
+/*
+ * Note that readdir is not thread-safe according to the POSIX spec.
+ */
+
+//export cfs_readdir
+func cfs_readdir(id C.int64_t, fd C.int, dirents []C.struct_cfs_dirent, count C.int) (n C.int) {
+	c, exist := getClient(int64(id))
+	if !exist {
+		return statusEINVAL
+	}
+	defer c.stats.done(opReaddir, time.Now())
+
+	f := c.getFile(uint(fd))
+	if f == nil {
+		return statusEBADFD
+	}
+
+	if f.dirp == nil {
+		f.dirp = newDirStream(f.ino, c.mw.ReadDirLimit_ll)
+	}
+
+	dirp := f.dirp
+	for n < count {
+		dentry, err := dirp.entry()
+		if err != nil {
+			if n == 0 {
+				return errorToStatus(err)
+			}
+			break
+		}
+		if dentry == nil {
+			break
+		}
+
+		// fill up ino
+		dirents[n].ino = C.uint64_t(dentry.Inode)
+
+		// fill up d_type
+		if proto.IsRegular(dentry.Type) {
+			dirents[n].d_type = C.DT_REG
+		} else if proto.IsDir(dentry.Type) {
 			dirents[n].d_type = C.DT_DIR
-		} else if proto.IsSymlink(dirp.dirents[dirp.pos].Type) {
+		} else if proto.IsSymlink(dentry.Type) {
 			dirents[n].d_type = C.DT_LNK
 		} else {
 			dirents[n].d_type = C.DT_UNKNOWN
 		}
 
 		// fill up name
-		nameLen := len(dirp.dirents[dirp.pos].Name)
+		nameLen := len(dentry.Name)
 		if nameLen >= 256 {
 			nameLen = 255
 		}
-		hdr := (*reflect.StringHeader)(unsafe.Pointer(&dirp.dirents[dirp.pos].Name))
+		hdr := (*reflect.StringHeader)(unsafe.Pointer(&dentry.Name))
 		C.memcpy(unsafe.Pointer(&dirents[n].name[0]), unsafe.Pointer(hdr.Data), C.size_t(nameLen))
 		dirents[n].name[nameLen] = 0
 		dirents[n].nameLen = C.uint32_t(nameLen)
 		// advance cursor
-		dirp.pos++
+		dirp.advance()
 		n++
 	}
 
@@ -1166,6 +1788,7 @@ func cfs_lsdir(id C.int64_t, fd C.int, direntsInfo []C.struct_cfs_dirent_info, c
 	if !exist {
 		return statusEINVAL
 	}
+	defer c.stats.done(opLsdir, time.Now())
 
 	f := c.getFile(uint(fd))
 	if f == nil {
@@ -1173,75 +1796,94 @@ func cfs_lsdir(id C.int64_t, fd C.int, direntsInfo []C.struct_cfs_dirent_info, c
 	}
 
 	if f.dirp == nil {
-		f.dirp = &dirStream{}
-		dentries, err := c.mw.ReadDir_ll(f.ino)
-		if err != nil {
-			return errorToStatus(err)
-		}
-		f.dirp.dirents = dentries
+		f.dirp = newDirStream(f.ino, c.mw.ReadDirLimit_ll)
+	}
+
+	// The inodes are fetched a page at a time in the background, while the
+	// following dentries are read, which the dir stream prefetches as well.
+	var (
+		wg      sync.WaitGroup
+		missing int32
+		limit   = make(chan struct{}, maxLsdirInflightPages)
+	)
+	inodeIDS := make([]uint64, 0, count)
+	infos := make([]*proto.InodeInfo, count)
+	fetch := func(from, to int) {
+		wg.Add(1)
+		limit <- struct{}{}
+		// the page is sliced here, inodeIDS keeps being appended to while
+		// the fetch runs
+		go func(ids []uint64, out []*proto.InodeInfo) {
+			defer func() {
+				<-limit
+				wg.Done()
+			}()
+			c.mw.BatchInodeGetInto(ids, out)
+			for _, info := range out {
+				if info == nil {
+					atomic.StoreInt32(&missing, 1)
+					return
+				}
+			}
+		}(inodeIDS[from:to], infos[from:to])
 	}
 
 	dirp := f.dirp
-	inodeIDS := make([]uint64, count)
-	inodeMap := make(map[uint64]C.int)
-	for dirp.pos < len(dirp.dirents) && n < count {
-		inodeIDS[n] = dirp.dirents[dirp.pos].Inode
-		inodeMap[dirp.dirents[dirp.pos].Inode] = n
+	fetched := 0
+	for n < count {
+		dentry, err := dirp.entry()
+		if err != nil {
+			if n == 0 {
+				return errorToStatus(err)
+			}
+			break
+		}
+		if dentry == nil {
+			break
+		}
+		inodeIDS = append(inodeIDS, dentry.Inode)
 		// fill up d_type
-		if proto.IsRegular(dirp.dirents[dirp.pos].Type) {
+		if proto.IsRegular(dentry.Type) {
+			c.writeOut(dentry.Inode)
 			direntsInfo[n].d_type = C.DT_REG
-		} else if proto.IsDir(dirp.dirents[dirp.pos].Type) {
+		} else if proto.IsDir(dentry.Type) {
 			direntsInfo[n].d_type = C.DT_DIR
-		} else if proto.IsSymlink(dirp.dirents[dirp.pos].Type) {
+		} else if proto.IsSymlink(dentry.Type) {
 			direntsInfo[n].d_type = C.DT_LNK
 		} else {
 			direntsInfo[n].d_type = C.DT_UNKNOWN
 		}
-		nameLen := len(dirp.dirents[dirp.pos].Name)
+		nameLen := len(dentry.Name)
 		if nameLen >= 256 {
 			nameLen = 255
 		}
-		hdr := (*reflect.StringHeader)(unsafe.Pointer(&dirp.dirents[dirp.pos].Name))
+		hdr := (*reflect.StringHeader)(unsafe.Pointer(&dentry.Name))
 
 		C.memcpy(unsafe.Pointer(&direntsInfo[n].name[0]), unsafe.Pointer(hdr.Data), C.size_t(nameLen))
 		direntsInfo[n].name[nameLen] = 0
 		direntsInfo[n].nameLen = C.uint32_t(nameLen)
 
 		// advance cursor
-		dirp.pos++
+		dirp.advance()
 		n++
+		if int(n)-fetched == dirStreamPageSize {
+			fetch(fetched, int(n))
+			fetched = int(n)
+		}
 	}
+	if int(n) > fetched {
+		fetch(fetched, int(n))
+	}
+	wg.Wait()
 	if n == 0 {
 		return n
 	}
-	infos := c.mw.BatchInodeGet(inodeIDS)
-	if len(infos) != int(n) {
+	if missing != 0 {
 		return statusEIO
 	}
-	for i := 0; i < len(infos); i++ {
-		// fill up the stat
-		index := inodeMap[infos[i].Inode]
-		direntsInfo[index].stat.size = C.uint64_t(infos[i].Size)
 
-		// fill up the mode
-		if proto.IsRegular(infos[i].Mode) {
-			direntsInfo[index].stat.mode = C.uint32_t(C.S_IFREG) | C.uint32_t(infos[i].Mode&0o777)
-		} else if proto.IsDir(infos[i].Mode) {
-			direntsInfo[index].stat.mode = C.uint32_t(C.S_IFDIR) | C.uint32_t(infos[i].Mode&0o777)
-		} else if proto.IsSymlink(infos[i].Mode) {
-			direntsInfo[index].stat.mode = C.uint32_t(C.S_IFLNK) | C.uint32_t(infos[i].Mode&0o777)
-		} else {
-			direntsInfo[index].stat.mode = C.uint32_t(C.S_IFSOCK) | C.uint32_t(infos[i].Mode&0o777)
-		}
-
-		// fill up the time struct
-		t := infos[index].AccessTime.UnixNano()
-		direntsInfo[index].stat.atime = C.uint64_t(t / 1e9)
-		direntsInfo[index].stat.atime_nsec = C.uint32_t(t % 1e9)
-
-		t = infos[index].ModifyTime.UnixNano()
-		direntsInfo[index].stat.mtime = C.uint64_t(t / 1e9)
-		direntsInfo[index].stat.mtime_nsec = C.uint32_t(t % 1e9)
+	for i := 0; i < int(n); i++ {
+		fillHDFSStatInfo(infos[i], &direntsInfo[i].stat)
 	}
 	return n
 }
@@ -1252,6 +1894,7 @@ func cfs_mkdirs(id C.int64_t, path *C.char, mode C.mode_t) C.int {
 	if !exist {
 		return statusEINVAL
 	}
+	defer c.stats.done(opMkdirs, time.Now())
 
 	start := time.Now()
 	var gerr error
@@ -1271,15 +1914,21 @@ func cfs_mkdirs(id C.int64_t, path *C.char, mode C.mode_t) C.int {
 	}()
 
 	pino := proto.RootIno
+	curpath := "/"
 	dirs := strings.Split(dirpath, "/")
 	for _, dir := range dirs {
 		if dir == "/" || dir == "" {
 			continue
 		}
+		curpath = gopath.Join(curpath, dir)
 		child, _, err := c.mw.Lookup_ll(pino, dir)
 		if err != nil {
 			if err == syscall.ENOENT {
 				info, err := c.mkdir(pino, dir, uint32(mode), dirpath)
+				c.nc.Delete(curpath)
+				if err == nil {
+					c.sc.Add(gopath.Dir(curpath), summaryDelta(info, false))
+				}
 
 				if err != nil {
 					if err != syscall.EEXIST {
@@ -1314,6 +1963,7 @@ func cfs_rmdir(id C.int64_t, path *C.char) C.int {
 	if !exist {
 		return statusEINVAL
 	}
+	defer c.stats.done(opRmdir, time.Now())
 	start := time.Now()
 	var err error
 	var info *proto.InodeInfo
@@ -1335,6 +1985,9 @@ func cfs_rmdir(id C.int64_t, path *C.char) C.int {
 	info, err = c.mw.Delete_ll(dirInfo.Inode, name, true, absPath)
 	c.ic.Delete(dirInfo.Inode)
 	c.dc.Delete(absPath)
+	if err == nil {
+		c.sc.Add(gopath.Dir(absPath), meta.SummaryInfo{Subdirs: -1})
+	}
 	return errorToStatus(err)
 }
 
@@ -1344,6 +1997,7 @@ func cfs_unlink(id C.int64_t, path *C.char) C.int {
 	if !exist {
 		return statusEINVAL
 	}
+	defer c.stats.done(opUnlink, time.Now())
 
 	start := time.Now()
 	var err error
@@ -1381,6 +2035,9 @@ func cfs_unlink(id C.int64_t, path *C.char) C.int {
 		_ = c.mw.Evict(info.Inode, absPath)
 		c.ic.Delete(info.Inode)
 		c.dc.Delete(absPath)
+		c.sc.Add(gopath.Dir(absPath), summaryDelta(info, true))
+	} else {
+		c.sc.Invalidate(gopath.Dir(absPath))
 	}
 	return 0
 }
@@ -1391,6 +2048,7 @@ func cfs_rename(id C.int64_t, from *C.char, to *C.char, overwritten bool) C.int
 	if !exist {
 		return statusEINVAL
 	}
+	defer c.stats.done(opRename, time.Now())
 
 	c.mu.Lock()
 	start := time.Now()
@@ -1421,6 +2079,9 @@ func cfs_rename(id C.int64_t, from *C.char, to *C.char, overwritten bool) C.int
 	c.ic.Delete(dstDirInfo.Inode)
 	c.dc.Delete(absFrom)
 	c.dc.Delete(absTo)
+	c.nc.DeleteTree(absTo)
+	c.sc.InvalidateTree(absFrom)
+	c.sc.InvalidateTree(absTo)
 	return errorToStatus(err)
 }
 
@@ -1430,6 +2091,7 @@ func cfs_fchmod(id C.int64_t, fd C.int, mode C.mode_t) C.int {
 	if !exist {
 		return statusEINVAL
 	}
+	defer c.stats.done(opFchmod, time.Now())
 
 	f := c.getFile(uint(fd))
 	if f == nil {
@@ -1455,22 +2117,17 @@ func cfs_getsummary(id C.int64_t, path *C.char, summary *C.struct_cfs_summary_in
 	if !exist {
 		return statusEINVAL
 	}
+	defer c.stats.done(opGetSummary, time.Now())
 
-	info, err := c.lookupPath(c.absPath(C.GoString(path)))
+	absPath := c.absPath(C.GoString(path))
+	info, err := c.lookupPath(absPath)
 	if err != nil {
 		return errorToStatus(err)
 	}
 
 	if strings.ToLower(C.GoString(useCache)) == "true" {
-		cacheSummaryInfo := c.sc.Get(info.Inode)
-		if cacheSummaryInfo != nil {
-			summary.filesHdd = C.int64_t(cacheSummaryInfo.FilesHdd)
-			summary.filesSsd = C.int64_t(cacheSummaryInfo.FilesSsd)
-			summary.filesBlobStore = C.int64_t(cacheSummaryInfo.FilesBlobStore)
-			summary.fbytesHdd = C.int64_t(cacheSummaryInfo.FbytesHdd)
-			summary.fbytesSsd = C.int64_t(cacheSummaryInfo.FbytesSsd)
-			summary.fbytesBlobStore = C.int64_t(cacheSummaryInfo.FbytesBlobStore)
-			summary.subdirs = C.int64_t(cacheSummaryInfo.Subdirs)
+		if summaryInfo, ok := c.sc.Get(absPath); ok {
+			fillSummaryInfo(&summaryInfo, summary)
 			return statusOK
 		}
 	}
@@ -1484,21 +2141,87 @@ func cfs_getsummary(id C.int64_t, path *C.char, summary *C.struct_cfs_summary_in
 		return errorToStatus(err)
 	}
 	if strings.ToLower(C.GoString(useCache)) != "false" {
-		c.sc.Put(info.Inode, &summaryInfo)
+		c.sc.Put(absPath, summaryInfo)
+	}
+
+	fillSummaryInfo(&summaryInfo, summary)
+	return statusOK
+}
+
+func fillSummaryInfo(summaryInfo *meta.SummaryInfo, summary *C.struct_cfs_summary_info) {
+	summary.filesHdd = C.int64_t(summaryInfo.FilesHdd)
+	summary.filesSsd = C.int64_t(summaryInfo.FilesSsd)
+	summary.filesBlobStore = C.int64_t(summaryInfo.FilesBlobStore)
+	summary.fbytesHdd = C.int64_t(summaryInfo.FbytesHdd)
+	summary.fbytesSsd = C.int64_t(summaryInfo.FbytesSsd)
+	summary.fbytesBlobStore = C.int64_t(summaryInfo.FbytesBlobStore)
+	summary.subdirs = C.int64_t(summaryInfo.Subdirs)
+}
+
+// internals
+
+func fillStatInfo(info *proto.InodeInfo, stat *C.struct_cfs_stat_info) {
+	stat.ino = C.uint64_t(info.Inode)
+	stat.size = C.uint64_t(info.Size)
+	stat.nlink = C.uint32_t(info.Nlink)
+	stat.blk_size = C.uint32_t(defaultBlkSize)
+	stat.uid = C.uint32_t(info.Uid)
+	stat.gid = C.uint32_t(info.Gid)
+
+	if info.Size%512 != 0 {
+		stat.blocks = C.uint64_t(info.Size>>9) + 1
+	} else {
+		stat.blocks = C.uint64_t(info.Size >> 9)
+	}
+	// fill up the mode
+	if proto.IsRegular(info.Mode) {
+		stat.mode = C.uint32_t(C.S_IFREG) | C.uint32_t(info.Mode&0o777)
+	} else if proto.IsDir(info.Mode) {
+		stat.mode = C.uint32_t(C.S_IFDIR) | C.uint32_t(info.Mode&0o777)
+	} else if proto.IsSymlink(info.Mode) {
+		stat.mode = C.uint32_t(C.S_IFLNK) | C.uint32_t(info.Mode&0o777)
+	} else {
+		stat.mode = C.uint32_t(C.S_IFSOCK) | C.uint32_t(info.Mode&0o777)
 	}
 
-	summary.filesHdd = C.int64_t(summaryInfo.FilesHdd)
-	summary.filesSsd = C.int64_t(summaryInfo.FilesSsd)
-	summary.filesBlobStore = C.int64_t(summaryInfo.FilesBlobStore)
-	summary.fbytesHdd = C.int64_t(summaryInfo.FbytesHdd)
-	summary.fbytesSsd = C.int64_t(summaryInfo.FbytesSsd)
-	summary.fbytesBlobStore = C.int64_t(summaryInfo.FbytesBlobStore)
-	summary.subdirs = C.int64_t(summaryInfo.Subdirs)
-	return statusOK
+	// fill up the time struct
+	t := info.AccessTime.UnixNano()
+	stat.atime = C.uint64_t(t / 1e9)
+	stat.atime_nsec = C.uint32_t(t % 1e9)
+
+	t = info.ModifyTime.UnixNano()
+	stat.mtime = C.uint64_t(t / 1e9)
+	stat.mtime_nsec = C.uint32_t(t % 1e9)
+
+	t = info.CreateTime.UnixNano()
+	stat.ctime = C.uint64_t(t / 1e9)
+	stat.ctime_nsec = C.uint32_t(t % 1e9)
+}
+
+func fillHDFSStatInfo(info *proto.InodeInfo, stat *C.struct_cfs_hdfs_stat_info) {
+	stat.size = C.uint64_t(info.Size)
+
+	// fill up the mode
+	if proto.IsRegular(info.Mode) {
+		stat.mode = C.mode_t(C.S_IFREG) | C.mode_t(info.Mode&0o777)
+	} else if proto.IsDir(info.Mode) {
+		stat.mode = C.mode_t(C.S_IFDIR) | C.mode_t(info.Mode&0o777)
+	} else if proto.IsSymlink(info.Mode) {
+		stat.mode = C.mode_t(C.S_IFLNK) | C.mode_t(info.Mode&0o777)
+	} else {
+		stat.mode = C.mode_t(C.S_IFSOCK) | C.mode_t(info.Mode&0o777)
+	}
+
+	// fill up the time struct
+	t := info.AccessTime.UnixNano()
+	stat.atime = C.uint64_t(t / 1e9)
+	stat.atime_nsec = C.uint32_t(t % 1e9)
+
+	t = info.ModifyTime.UnixNano()
+	stat.mtime = C.uint64_t(t / 1e9)
+	stat.mtime_nsec = C.uint32_t(t % 1e9)
 }
 
-// internals
-
 func (c *client) absPath(path string) string {
 	p := gopath.Clean(path)
 	if !gopath.IsAbs(p) {
@@ -1543,9 +2266,12 @@ func (c *client) start() (err error) {
 		}
 	}
 
-	if c.enableSummary {
-		c.sc = fs.NewSummaryCache(fs.DefaultSummaryExpiration, fs.MaxSummaryCache)
-	}
+	c.initMetaCache()
+	defer func() {
+		if err != nil {
+			c.releaseMetaCache()
+		}
+	}()
 	if c.enableBcache {
 		c.bc = bcache.NewBcacheClient()
 	}
@@ -1571,10 +2297,18 @@ func (c *client) start() (err error) {
 		ValidateOwner: false,
 		EnableSummary: c.enableSummary,
 		InnerReq:      c.enableInnerReq,
+
+		PathCacheExpiration: c.pathCacheTimeout,
+		PathCacheMaxEntries: c.pathCacheMaxEntries,
 	}); err != nil {
 		log.LogErrorf("newClient NewMetaWrapper failed(%v)", err)
 		return err
 	}
+	defer func() {
+		if err != nil {
+			_ = mw.Close()
+		}
+	}()
 	var ec *stream.ExtentClient
 	if ec, err = stream.NewExtentClient(&stream.ExtentConfig{
 		Volume:                      c.volName,
@@ -1594,14 +2328,31 @@ func (c *client) start() (err error) {
 		VolCacheDpStorageClass:      c.cacheDpStorageClass,
 		OnRenewalForbiddenMigration: mw.RenewalForbiddenMigration,
 		OnForbiddenMigration:        mw.ForbiddenMigration,
+		ReadAheadMemMB:              c.readAheadMemMB,
+		ReadAheadWindowMB:           c.readAheadWindowMB,
+		ReadPipelineDepth:           c.readPipelineDepth,
+		HedgeReadPercentile:         c.hedgeReadPercentile,
 	}); err != nil {
 		log.LogErrorf("newClient NewExtentClient failed(%v)", err)
 		return
 	}
+	defer func() {
+		if err != nil {
+			_ = ec.Close()
+			c.mw, c.ec, c.ebsc = nil, nil, nil
+		}
+	}()
 
 	c.mw = mw
 	c.ec = ec
 	c.ebsc = ebsc
+
+	if c.statsAddr != "" {
+		if c.statsServer, err = c.serveStats(c.statsAddr); err != nil {
+			log.LogErrorf("newClient serveStats failed(%v)", err)
+			return
+		}
+	}
 	return nil
 }
 
@@ -1640,13 +2391,10 @@ func (c *client) checkPermission() (err error) {
 }
 
 func (c *client) allocFD(ino uint64, flags, mode uint32, fileCache bool, fileSize uint64, parentInode uint64, path string, storageClass uint32) *file {
-	c.fdlock.Lock()
-	defer c.fdlock.Unlock()
-	fd, ok := c.fdset.NextClear(0)
-	if !ok || fd > maxFdNum {
+	fd, ok := c.fds.alloc()
+	if !ok {
 		return nil
 	}
-	c.fdset.Set(fd)
 	f := &file{fd: fd, ino: ino, flags: flags, mode: mode, pino: parentInode, path: path, storageClass: storageClass}
 	if flags&0x0f != syscall.O_RDONLY {
 		f.openForWrite = true
@@ -1685,27 +2433,21 @@ func (c *client) allocFD(ino uint64, flags, mode uint32, fileCache bool, fileSiz
 			f.fileWriter = blobstore.NewWriter(clientConf)
 			f.fileReader = nil
 		}
+		f.ctx = c.ctx(c.id, ino)
 	}
-	c.fdmap[fd] = f
+	c.fds.store(fd, f)
 	return f
 }
 
 func (c *client) getFile(fd uint) *file {
-	c.fdlock.Lock()
-	f := c.fdmap[fd]
-	c.fdlock.Unlock()
-	return f
+	return c.fds.get(fd)
 }
 
 func (c *client) releaseFD(fd uint) *file {
-	c.fdlock.Lock()
-	defer c.fdlock.Unlock()
-	f, ok := c.fdmap[fd]
-	if !ok {
+	f := c.fds.release(fd)
+	if f == nil {
 		return nil
 	}
-	delete(c.fdmap, fd)
-	c.fdset.Clear(fd)
 	c.ic.Delete(f.ino)
 	return f
 }
@@ -1713,13 +2455,24 @@ func (c *client) releaseFD(fd uint) *file {
 func (c *client) lookupPath(path string) (*proto.InodeInfo, error) {
 	ino, ok := c.dc.Get(gopath.Clean(path))
 	if !ok {
+		if c.nc != nil {
+			if c.nc.Has(gopath.Clean(path)) {
+				exporter.NewCounter("negDentryCacheHit").AddWithLabels(1, map[string]string{exporter.Vol: c.volName})
+				return nil, syscall.ENOENT
+			}
+			exporter.NewCounter("negDentryCacheMiss").AddWithLabels(1, map[string]string{exporter.Vol: c.volName})
+		}
 		inoInterval, err := c.mw.LookupPath(gopath.Clean(path))
+		if err == syscall.ENOENT {
+			c.nc.Put(gopath.Clean(path))
+		}
 		if err != nil {
 			return nil, err
 		}
 		c.dc.Put(gopath.Clean(path), inoInterval)
 		ino = inoInterval
 	}
+	c.writeOut(ino)
 	info := c.ic.Get(ino)
 	if info != nil {
 		return info, nil
@@ -1733,6 +2486,137 @@ func (c *client) lookupPath(path string) (*proto.InodeInfo, error) {
 	return info, nil
 }
 
+// statPaths resolves the absolute paths and fetches their inodes. The paths
+// are resolved by resolvePaths, and the inodes missing from the inode cache
+// are fetched with a single BatchInodeGet, which sends one request per meta
+// partition.
+func (c *client) statPaths(paths []string) ([]*proto.InodeInfo, []error) {
+	inodes, errs := c.resolvePaths(paths, func(parent uint64, name string) (uint64, error) {
+		ino, _, err := c.mw.Lookup_ll(parent, name)
+		return ino, err
+	})
+
+	infos := make([]*proto.InodeInfo, len(paths))
+	var missing []uint64
+	for i, ino := range inodes {
+		if errs[i] != nil {
+			continue
+		}
+		c.writeOut(ino)
+		if infos[i] = c.ic.Get(ino); infos[i] == nil {
+			missing = append(missing, ino)
+		}
+	}
+	if len(missing) == 0 {
+		return infos, errs
+	}
+
+	fetched := make(map[uint64]*proto.InodeInfo, len(missing))
+	for _, info := range c.mw.BatchInodeGet(missing) {
+		c.ic.Put(info)
+		fetched[info.Inode] = info
+	}
+	for i, ino := range inodes {
+		if errs[i] != nil || infos[i] != nil {
+			continue
+		}
+		if infos[i] = fetched[ino]; infos[i] == nil {
+			errs[i] = syscall.ENOENT
+		}
+	}
+	return infos, errs
+}
+
+// pathTrie is a node of the trie of the components of the paths resolved
+// by resolvePaths.
+type pathTrie struct {
+	children map[string]*pathTrie
+	paths    []int // indexes of the paths ending at the node
+}
+
+func (t *pathTrie) child(name string) *pathTrie {
+	if t.children == nil {
+		t.children = make(map[string]*pathTrie)
+	}
+	child := t.children[name]
+	if child == nil {
+		child = &pathTrie{}
+		t.children[name] = child
+	}
+	return child
+}
+
+// fail sets err to the paths at and below t.
+func (t *pathTrie) fail(errs []error, err error) {
+	for _, i := range t.paths {
+		errs[i] = err
+	}
+	for _, child := range t.children {
+		child.fail(errs, err)
+	}
+}
+
+// resolvePaths returns the inodes of the absolute clean paths. The paths are
+// walked as a trie of their components, so that a prefix shared by several
+// paths is looked up once, and the subtrees are walked concurrently. The
+// dentry cache is consulted first, then the negative dentry cache, before
+// lookup is called with the parent inode and the name.
+func (c *client) resolvePaths(paths []string, lookup func(parent uint64, name string) (uint64, error)) ([]uint64, []error) {
+	inodes := make([]uint64, len(paths))
+	errs := make([]error, len(paths))
+	root := &pathTrie{}
+	for i, p := range paths {
+		node := root
+		for _, name := range strings.Split(p, "/") {
+			if name != "" {
+				node = node.child(name)
+			}
+		}
+		node.paths = append(node.paths, i)
+	}
+
+	var (
+		wg    sync.WaitGroup
+		limit = make(chan struct{}, maxBatchIOConcurrency)
+		walk  func(node *pathTrie, path string, ino uint64)
+	)
+	resolve := func(node *pathTrie, path string, parent uint64, name string) {
+		defer wg.Done()
+		ino, ok := c.dc.Get(path)
+		if !ok {
+			if c.nc.Has(path) {
+				node.fail(errs, syscall.ENOENT)
+				return
+			}
+			var err error
+			limit <- struct{}{}
+			ino, err = lookup(parent, name)
+			<-limit
+			if err == syscall.ENOENT {
+				c.nc.Put(path)
+			}
+			if err != nil {
+				node.fail(errs, err)
+				return
+			}
+			c.dc.Put(path, ino)
+		}
+		walk(node, path, ino)
+	}
+	walk = func(node *pathTrie, path string, ino uint64) {
+		for _, i := range node.paths {
+			inodes[i] = ino
+		}
+		for name, child := range node.children {
+			wg.Add(1)
+			go resolve(child, gopath.Join(path, name), ino, name)
+		}
+	}
+	walk(root, "/", proto.RootIno)
+	wg.Wait()
+	return inodes, errs
+}
+
 func (c *client) lockDir(ino uint64, lease uint64, lockId int64) (retLockId int64, err error) {
 	return c.mw.LockDir(ino, lease, lockId)
 }
@@ -1765,7 +2649,12 @@ func (c *client) setattr(info *proto.InodeInfo, valid uint32, mode, uid, gid uin
 
 func (c *client) create(pino uint64, name string, mode uint32, fullPath string) (info *proto.InodeInfo, err error) {
 	fuseMode := mode & 0o777
-	return c.mw.Create_ll(pino, name, fuseMode, 0, 0, nil, fullPath, false)
+	info, err = c.mw.Create_ll(pino, name, fuseMode, 0, 0, nil, fullPath, false)
+	if err == nil {
+		c.nc.Delete(fullPath)
+		c.sc.Add(gopath.Dir(fullPath), summaryDelta(info, false))
+	}
+	return
 }
 
 func (c *client) mkdir(pino uint64, name string, mode uint32, fullPath string) (info *proto.InodeInfo, err error) {
@@ -1783,6 +2672,7 @@ func (c *client) openStream(f *file) {
 }
 
 func (c *client) closeStream(f *file) {
+	c.putWriteBehind(f)
 	_ = c.ec.CloseStream(f.ino)
 	_ = c.ec.EvictStream(f.ino)
 	f.fileWriter.FreeCache()
@@ -1791,25 +2681,125 @@ func (c *client) closeStream(f *file) {
 }
 
 func (c *client) flush(f *file) error {
+	if f.wb != nil {
+		if err := f.wb.Flush(); err != nil {
+			return err
+		}
+	}
 	if proto.IsHot(c.volType) || proto.IsStorageClassReplica(f.storageClass) {
 		return c.ec.Flush(f.ino)
 	} else {
 		if f.fileWriter != nil {
-			return f.fileWriter.Flush(f.ino, c.ctx(c.id, f.ino))
+			return f.fileWriter.Flush(f.ino, f.ctx)
 		}
 	}
 	return nil
 }
 
+// flushOpenFiles writes out the buffered writes of the files left open when
+// the client is closed, the errors are only logged.
+func (c *client) flushOpenFiles() {
+	for _, f := range c.fds.files() {
+		if !f.openForWrite {
+			continue
+		}
+		if err := c.flush(f); err != nil {
+			log.LogErrorf("flushOpenFiles: ino(%v) fd(%v) err(%v)", f.ino, f.fd, err)
+		}
+	}
+}
+
 func (c *client) truncate(f *file, size int) error {
+	if err := c.flushWriteBehind(f); err != nil {
+		return err
+	}
 	err := c.ec.Truncate(c.mw, f.pino, f.ino, size, f.path)
 	if err != nil {
 		return err
 	}
+	c.sc.Invalidate(gopath.Dir(f.path))
 	return nil
 }
 
 func (c *client) write(f *file, offset int, data []byte, flags int) (n int, err error) {
+	if f.wb != nil && flags == 0 {
+		return f.wb.Write(offset, data)
+	}
+	// after the writes buffered by the other descriptors of the file
+	c.writeOut(f.ino)
+	return c.writeThrough(f, offset, data, flags)
+}
+
+// setupWriteBehind buffers the writes of f if writeBehindFlushMs is set.
+// Only the files of replica storage are buffered, and never the files opened
+// with O_SYNC, O_DSYNC, O_DIRECT or O_APPEND, whose writes keep their
+// durability and ordering.
+func (c *client) setupWriteBehind(f *file) {
+	if c.writeBehindDelay <= 0 || !f.openForWrite {
+		return
+	}
+	if !proto.IsHot(c.volType) && !proto.IsStorageClassReplica(f.storageClass) {
+		return
+	}
+	if flags, wait := c.writeFlags(f); flags != 0 || wait {
+		return
+	}
+	c.getWriteBehind(f, func(offset int, data []byte) (int, error) {
+		// only the fields of the inode are used, f may be closed
+		return c.writeThrough(f, offset, data, 0)
+	})
+}
+
+// getWriteBehind sets the write-behind buffer of f to the one of its inode,
+// which is created with write by the first descriptor.
+func (c *client) getWriteBehind(f *file, write writeFunc) {
+	c.wbMu.Lock()
+	defer c.wbMu.Unlock()
+	wb := c.writeBehinds[f.ino]
+	if wb == nil {
+		wb = newWriteBehind(f.ino, c.writeBehindDelay, write)
+		c.writeBehinds[f.ino] = wb
+	}
+	wb.refs++
+	f.wb = wb
+}
+
+// putWriteBehind releases the write-behind buffer of f, f must have been
+// flushed.
+func (c *client) putWriteBehind(f *file) {
+	if f.wb == nil {
+		return
+	}
+	c.wbMu.Lock()
+	defer c.wbMu.Unlock()
+	if f.wb.refs--; f.wb.refs == 0 {
+		delete(c.writeBehinds, f.ino)
+	}
+	f.wb = nil
+}
+
+// flushWriteBehind writes out the buffered writes of the file of f before
+// it's read or truncated through f. An error is returned to a writer only.
+func (c *client) flushWriteBehind(f *file) error {
+	if f.wb != nil {
+		return f.wb.Flush()
+	}
+	c.writeOut(f.ino)
+	return nil
+}
+
+// writeOut writes out the buffered writes of inode ino before it's read or
+// stat, its cached attributes are dropped if any data was buffered.
+func (c *client) writeOut(ino uint64) {
+	c.wbMu.Lock()
+	wb := c.writeBehinds[ino]
+	c.wbMu.Unlock()
+	if wb != nil && wb.WriteOut() {
+		c.ic.Delete(ino)
+	}
+}
+
+func (c *client) writeThrough(f *file, offset int, data []byte, flags int) (n int, err error) {
 	if proto.IsHot(c.volType) || proto.IsStorageClassReplica(f.storageClass) {
 		c.ec.GetStreamer(f.ino).SetParentInode(f.pino) // set the parent inode
 		checkFunc := func() error {
@@ -1828,7 +2818,7 @@ func (c *client) write(f *file, offset int, data []byte, flags int) (n int, err
 		}
 		n, err = c.ec.Write(f.ino, offset, data, flags, checkFunc, f.storageClass, false)
 	} else {
-		n, err = f.fileWriter.Write(c.ctx(c.id, f.ino), offset, data, flags)
+		n, err = f.fileWriter.Write(f.ctx, offset, data, flags)
 	}
 	if err != nil {
 		return 0, err
@@ -1837,10 +2827,13 @@ func (c *client) write(f *file, offset int, data []byte, flags int) (n int, err
 }
 
 func (c *client) read(f *file, offset int, data []byte) (n int, err error) {
+	if err = c.flushWriteBehind(f); err != nil {
+		return 0, err
+	}
 	if proto.IsHot(c.volType) || proto.IsStorageClassReplica(f.storageClass) {
 		n, err = c.ec.Read(f.ino, data, offset, len(data), f.storageClass, false)
 	} else {
-		n, err = f.fileReader.Read(c.ctx(c.id, f.ino), data, offset, len(data))
+		n, err = f.fileReader.Read(f.ctx, data, offset, len(data))
 	}
 	if err != nil && err != io.EOF {
 		return 0, err
@@ -1848,6 +2841,351 @@ func (c *client) read(f *file, offset int, data []byte) (n int, err error) {
 	return n, nil
 }
 
+// mmapRO maps the file of f, the mapping is created by the first fd of the
+// client mapping the file and shared by the others.
+func (c *client) mmapRO(f *file) (*roMapping, error) {
+	c.writeOut(f.ino)
+	c.mu.Lock()
+	defer c.mu.Unlock()
+	if f.mmap == nil {
+		m := c.mappings[f.ino]
+		if m == nil {
+			info, err := c.mw.InodeGet_ll(f.ino)
+			if err != nil {
+				return nil, err
+			}
+			if info.Size == 0 {
+				return nil, nil
+			}
+			if m, err = newROMapping(f.ino, int(info.Size), nil); err != nil {
+				return nil, err
+			}
+			m.read = func(offset int, data []byte) (int, error) {
+				return c.readMapping(m, offset, data)
+			}
+			c.mappings[f.ino] = m
+		}
+		f.mmap = m
+		m.files = append(m.files, f)
+	}
+	f.mmaps++
+	f.mmap.maps++
+	return f.mmap, nil
+}
+
+// readMapping loads the mapping m through any of the fds mapping it.
+func (c *client) readMapping(m *roMapping, offset int, data []byte) (int, error) {
+	c.mu.Lock()
+	var f *file
+	if len(m.files) > 0 {
+		f = m.files[0]
+	}
+	c.mu.Unlock()
+	if f == nil {
+		return 0, syscall.EBADF
+	}
+	return c.read(f, offset, data)
+}
+
+// getMapping returns the mapping of f, which is kept until putMapping is
+// called even if it's unmapped meanwhile.
+func (c *client) getMapping(f *file) *roMapping {
+	c.mu.Lock()
+	defer c.mu.Unlock()
+	if f.mmap != nil {
+		f.mmap.inflight++
+	}
+	return f.mmap
+}
+
+func (c *client) putMapping(m *roMapping) {
+	c.mu.Lock()
+	defer c.mu.Unlock()
+	m.inflight--
+	c.releaseMapping(m)
+}
+
+// munmap undoes a cfs_mmap_ro call on f, or all of them if all is set.
+func (c *client) munmap(f *file, all bool) bool {
+	c.mu.Lock()
+	defer c.mu.Unlock()
+	m := f.mmap
+	if m == nil {
+		return false
+	}
+	n := 1
+	if all {
+		n = f.mmaps
+	}
+	f.mmaps -= n
+	m.maps -= n
+	if f.mmaps == 0 {
+		f.mmap = nil
+		for i, mf := range m.files {
+			if mf == f {
+				m.files = append(m.files[:i], m.files[i+1:]...)
+				break
+			}
+		}
+	}
+	c.releaseMapping(m)
+	return true
+}
+
+// releaseMappings releases the mappings of a closing client, the ones in use
+// by a prefetch are unmapped once it returns.
+func (c *client) releaseMappings() {
+	c.mu.Lock()
+	defer c.mu.Unlock()
+	for _, m := range c.mappings {
+		for _, f := range m.files {
+			f.mmap, f.mmaps = nil, 0
+		}
+		m.files = nil
+		m.maps = 0
+		c.releaseMapping(m)
+	}
+	c.mappings = make(map[uint64]*roMapping)
+}
+
+// releaseMapping unmaps m once it's neither mapped nor in use, it must be
+// called with mu held.
+func (c *client) releaseMapping(m *roMapping) {
+	if m.maps > 0 || m.inflight > 0 {
+		return
+	}
+	if c.mappings[m.ino] == m {
+		delete(c.mappings, m.ino)
+	}
+	m.unmap()
+}
+
+type aioEvent struct {
+	userData uint64
+	res      int64
+}
+
+// aioContext is the completion queue of the asynchronous I/O of a client.
+type aioContext struct {
+	depth    int32
+	inflight int32
+	efd      int // eventfd notified on every completion, -1 if not set
+	events   chan aioEvent
+
+	mu      sync.RWMutex
+	closed  bool
+	running sync.WaitGroup
+	done    chan struct{} // closed by close
+}
+
+func newAioContext(depth int, efd int) *aioContext {
+	return &aioContext{
+		depth:  int32(depth),
+		efd:    efd,
+		events: make(chan aioEvent, depth),
+		done:   make(chan struct{}),
+	}
+}
+
+// acquire reserves a slot for a new request, inflight counts the requests
+// whose events have not been reaped, so the events channel never blocks.
+func (ctx *aioContext) acquire() bool {
+	for {
+		inflight := atomic.LoadInt32(&ctx.inflight)
+		if inflight >= ctx.depth {
+			return false
+		}
+		if atomic.CompareAndSwapInt32(&ctx.inflight, inflight, inflight+1) {
+			return true
+		}
+	}
+}
+
+func (ctx *aioContext) release() {
+	atomic.AddInt32(&ctx.inflight, -1)
+}
+
+// submit runs execute in the background, its result is queued as the event
+// of userData. It returns false if the queue is full or ctx is closed.
+func (ctx *aioContext) submit(userData uint64, execute func() int64) bool {
+	ctx.mu.RLock()
+	defer ctx.mu.RUnlock()
+	if ctx.closed || !ctx.acquire() {
+		return false
+	}
+	ctx.running.Add(1)
+	go func() {
+		defer ctx.running.Done()
+		ctx.complete(userData, execute())
+	}()
+	return true
+}
+
+func (ctx *aioContext) complete(userData uint64, res int64) {
+	ctx.events <- aioEvent{userData: userData, res: res}
+	if ctx.efd >= 0 {
+		var val [8]byte
+		*(*uint64)(unsafe.Pointer(&val[0])) = 1
+		if _, err := syscall.Write(ctx.efd, val[:]); err != nil {
+			log.LogWarnf("aio complete: notify eventfd(%v) failed, err(%v)", ctx.efd, err)
+		}
+	}
+}
+
+// getEvents passes the events to put, at least minNr of them unless timeout
+// expires first, and at most maxNr. A negative timeout waits forever.
+// Once the context is closed, it returns the events left, or EINVAL if
+// there are none.
+func (ctx *aioContext) getEvents(minNr, maxNr int, timeout time.Duration, put func(i int, ev aioEvent)) (int, error) {
+	var expired <-chan time.Time
+	if timeout >= 0 {
+		timer := time.NewTimer(timeout)
+		defer timer.Stop()
+		expired = timer.C
+	}
+
+	n := 0
+	for n < maxNr {
+		var ev aioEvent
+		if n < minNr {
+			select {
+			case ev = <-ctx.events:
+			case <-expired:
+				return n, nil
+			case <-ctx.done:
+				// the events of the requests done before the close are
+				// still reaped, and the ones reaped are returned
+				select {
+				case ev = <-ctx.events:
+				default:
+					if n > 0 {
+						return n, nil
+					}
+					return 0, syscall.EINVAL
+				}
+			}
+		} else {
+			select {
+			case ev = <-ctx.events:
+			default:
+				return n, nil
+			}
+		}
+		ctx.release()
+		put(n, ev)
+		n++
+	}
+	return n, nil
+}
+
+// close waits for the requests in progress, and wakes up the callers of
+// getEvents.
+func (ctx *aioContext) close() {
+	ctx.mu.Lock()
+	ctx.closed = true
+	ctx.mu.Unlock()
+	ctx.running.Wait()
+	close(ctx.done)
+}
+
+func (c *client) aioContext() *aioContext {
+	ctx, _ := c.aio.Load().(*aioContext)
+	return ctx
+}
+
+func (c *client) setupAio(depth int, efd int) error {
+	if depth <= 0 {
+		return syscall.EINVAL
+	}
+	c.mu.Lock()
+	defer c.mu.Unlock()
+	if c.aioContext() != nil {
+		return syscall.EEXIST
+	}
+	c.aio.Store(newAioContext(depth, efd))
+	return nil
+}
+
+// destroyAio closes the aio context of c, once it returns the requests are
+// done and the eventfd is no longer used.
+func (c *client) destroyAio() error {
+	c.mu.Lock()
+	ctx := c.aioContext()
+	if ctx == nil {
+		c.mu.Unlock()
+		return syscall.EINVAL
+	}
+	c.aio.Store((*aioContext)(nil))
+	c.mu.Unlock()
+	ctx.close()
+	return nil
+}
+
+func (c *client) aioExecute(req *C.struct_cfs_aio_req) int64 {
+	f := c.getFile(uint(req.fd))
+	if f == nil {
+		return int64(statusEBADFD)
+	}
+	accFlags := f.flags & uint32(C.O_ACCMODE)
+
+	switch req.opcode {
+	case C.CFS_AIO_READ:
+		if accFlags == uint32(C.O_WRONLY) {
+			return int64(statusEACCES)
+		}
+		n, err := c.read(f, int(req.off), goBytes(req.buf, req.size))
+		if err != nil {
+			log.LogErrorf("aioExecute: read ino(%v) offset(%v) size(%v) err(%v)", f.ino, req.off, req.size, err)
+			return int64(statusEIO)
+		}
+		return int64(n)
+	case C.CFS_AIO_WRITE:
+		if accFlags != uint32(C.O_WRONLY) && accFlags != uint32(C.O_RDWR) {
+			return int64(statusEACCES)
+		}
+		flags, wait := c.writeFlags(f)
+		n, err := c.write(f, int(req.off), goBytes(req.buf, req.size), flags)
+		if err != nil {
+			log.LogErrorf("aioExecute: write ino(%v) offset(%v) size(%v) err(%v)", f.ino, req.off, req.size, err)
+			if err == syscall.ENOSPC {
+				return int64(statusENOSPC)
+			}
+			return int64(statusEIO)
+		}
+		if wait {
+			if err = c.flush(f); err != nil {
+				return int64(statusEIO)
+			}
+		}
+		return int64(n)
+	case C.CFS_AIO_FSYNC:
+		if err := c.flush(f); err != nil {
+			return int64(statusEIO)
+		}
+		return 0
+	default:
+		return int64(statusEINVAL)
+	}
+}
+
+// writeFlags returns the write flags of the file, and whether the data
+// should be flushed right after being written.
+func (c *client) writeFlags(f *file) (flags int, wait bool) {
+	if f.flags&uint32(C.O_DIRECT) != 0 || f.flags&uint32(C.O_SYNC) != 0 || f.flags&uint32(C.O_DSYNC) != 0 {
+		if proto.IsHot(c.volType) || proto.IsStorageClassReplica(f.storageClass) {
+			wait = true
+		}
+	}
+	if f.flags&uint32(C.O_APPEND) != 0 || proto.IsCold(c.volType) || proto.IsStorageClassBlobStore(f.storageClass) {
+		flags |= proto.FlagsAppend
+		flags |= proto.FlagsSyncWrite
+	}
+	return
+}
+
+// ctx builds the trace context of a file descriptor. It is built once per
+// descriptor, since a span per call costs a few allocations on every read
+// and write, and the track logs a span collects are bounded by the tracer.
 func (c *client) ctx(cid int64, ino uint64) context.Context {
 	_, ctx := trace.StartSpanFromContextWithTraceID(context.Background(), "", fmt.Sprintf("cid=%v,ino=%v", cid, ino))
 	return ctx
@@ -1882,6 +3220,25 @@ func (c *client) loadConfFromMaster(masters []string) (err error) {
 	return
 }
 
+func goBytes(ptr unsafe.Pointer, size C.size_t) (buffer []byte) {
+	hdr := (*reflect.SliceHeader)(unsafe.Pointer(&buffer))
+	hdr.Data = uintptr(ptr)
+	hdr.Len = int(size)
+	hdr.Cap = int(size)
+	return
+}
+
+func iovecSlice(iov *C.struct_iovec, iovcnt C.int) (vecs []C.struct_iovec) {
+	if iov == nil || iovcnt <= 0 {
+		return nil
+	}
+	hdr := (*reflect.SliceHeader)(unsafe.Pointer(&vecs))
+	hdr.Data = uintptr(unsafe.Pointer(iov))
+	hdr.Len = int(iovcnt)
+	hdr.Cap = int(iovcnt)
+	return
+}
+
 func parseLogLevel(loglvl string) log.Level {
 	var level log.Level
 	switch strings.ToLower(loglvl) {
@@ -0,0 +1,340 @@
+// Copyright 2024 The CubeFS Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+
+package main
+
+import (
+	"bytes"
+	"context"
+	"os"
+	"sync"
+	"sync/atomic"
+	"syscall"
+	"testing"
+	"time"
+
+	"github.com/cubefs/cubefs/blobstore/common/trace"
+	"github.com/cubefs/cubefs/client/fs"
+	"github.com/cubefs/cubefs/proto"
+	"github.com/stretchr/testify/require"
+)
+
+// traceCall stands for the span lookups done by a blobstore read or write.
+func traceCall(ctx context.Context) {
+	span := trace.SpanFromContextSafe(ctx)
+	_ = span.TraceID()
+}
+
+func BenchmarkTraceContextPerCall(b *testing.B) {
+	c := &client{id: 1}
+	b.ReportAllocs()
+	for i := 0; i < b.N; i++ {
+		traceCall(c.ctx(c.id, 1234))
+	}
+}
+
+func BenchmarkTraceContextPerFile(b *testing.B) {
+	c := &client{id: 1}
+	f := &file{ino: 1234}
+	f.ctx = c.ctx(c.id, f.ino)
+	b.ReportAllocs()
+	for i := 0; i < b.N; i++ {
+		traceCall(f.ctx)
+	}
+}
+
+// getAioEvents returns the events got by getEvents, by user data.
+func getAioEvents(t *testing.T, ctx *aioContext, minNr, maxNr int, timeout time.Duration) map[uint64]int64 {
+	events := make(map[uint64]int64)
+	n, err := ctx.getEvents(minNr, maxNr, timeout, func(i int, ev aioEvent) {
+		require.Equal(t, len(events), i)
+		events[ev.userData] = ev.res
+	})
+	require.NoError(t, err)
+	require.Equal(t, len(events), n)
+	return events
+}
+
+func TestAio(t *testing.T) {
+	c := &client{}
+	require.Equal(t, syscall.EINVAL, c.setupAio(0, -1))
+	require.Equal(t, syscall.EINVAL, c.destroyAio())
+
+	// the completions are notified on the eventfd
+	r, w, err := os.Pipe()
+	require.NoError(t, err)
+	defer r.Close()
+	defer w.Close()
+	require.NoError(t, c.setupAio(4, int(w.Fd())))
+	require.Equal(t, syscall.EEXIST, c.setupAio(4, -1))
+	ctx := c.aioContext()
+
+	release := make(chan struct{})
+	for i := uint64(1); i <= 4; i++ {
+		res := int64(i * 10)
+		require.True(t, ctx.submit(i, func() int64 {
+			<-release
+			return res
+		}))
+	}
+	// the queue is full until the events are reaped
+	require.False(t, ctx.submit(5, func() int64 { return 0 }))
+	require.Empty(t, getAioEvents(t, ctx, 1, 4, 10*time.Millisecond))
+	require.Empty(t, getAioEvents(t, ctx, 0, 4, -1))
+
+	close(release)
+	events := getAioEvents(t, ctx, 3, 3, -1)
+	require.Len(t, events, 3)
+	for userData, res := range events {
+		require.Equal(t, int64(userData*10), res)
+	}
+	require.True(t, ctx.submit(5, func() int64 { return 50 }))
+	events = getAioEvents(t, ctx, 2, 4, -1)
+	require.Len(t, events, 2)
+	require.Equal(t, int64(50), events[5])
+
+	notified := make([]byte, 5*8)
+	_, err = r.Read(notified)
+	require.NoError(t, err)
+
+	require.NoError(t, c.destroyAio())
+	require.Nil(t, c.aioContext())
+	require.Equal(t, syscall.EINVAL, c.destroyAio())
+	require.NoError(t, c.setupAio(1, -1))
+	require.NoError(t, c.destroyAio())
+}
+
+func TestAioDestroyWhileBusy(t *testing.T) {
+	c := &client{}
+	require.NoError(t, c.setupAio(4, -1))
+	ctx := c.aioContext()
+
+	var done int32
+	release := make(chan struct{})
+	for i := uint64(1); i <= 2; i++ {
+		require.True(t, ctx.submit(i, func() int64 {
+			<-release
+			atomic.AddInt32(&done, 1)
+			return 0
+		}))
+	}
+	waiting := make(chan int)
+	go func() {
+		n, err := ctx.getEvents(4, 4, -1, func(int, aioEvent) {})
+		require.NoError(t, err)
+		waiting <- n
+	}()
+
+	// destroy waits for the requests in progress, and wakes up the
+	// callers waiting for their events
+	destroyed := make(chan struct{})
+	go func() {
+		require.NoError(t, c.destroyAio())
+		close(destroyed)
+	}()
+	for closed := false; !closed; {
+		time.Sleep(time.Millisecond)
+		ctx.mu.RLock()
+		closed = ctx.closed
+		ctx.mu.RUnlock()
+	}
+	require.False(t, ctx.submit(3, func() int64 { return 0 }))
+	select {
+	case <-destroyed:
+		t.Fatal("destroyed with requests in progress")
+	case <-time.After(10 * time.Millisecond):
+	}
+	close(release)
+	<-destroyed
+	require.EqualValues(t, 2, atomic.LoadInt32(&done))
+	// the events reaped before the close are returned, and the callers
+	// fail afterwards
+	require.Equal(t, 2, <-waiting)
+	_, err := ctx.getEvents(1, 1, -1, func(int, aioEvent) {})
+	require.Equal(t, syscall.EINVAL, err)
+}
+
+// treeLookup looks up the names in a tree of directories, whose inodes are
+// given by path, and counts the lookups of each path.
+type treeLookup struct {
+	inodes map[string]uint64
+	paths  map[uint64]string
+
+	sync.Mutex
+	lookups map[string]int
+}
+
+func newTreeLookup(paths ...string) *treeLookup {
+	tl := &treeLookup{
+		inodes:  map[string]uint64{"/": proto.RootIno},
+		paths:   map[uint64]string{proto.RootIno: "/"},
+		lookups: make(map[string]int),
+	}
+	for i, p := range paths {
+		tl.inodes[p] = uint64(100 + i)
+		tl.paths[uint64(100+i)] = p
+	}
+	return tl
+}
+
+func (tl *treeLookup) lookup(parent uint64, name string) (uint64, error) {
+	path := tl.paths[parent] + "/" + name
+	if parent == proto.RootIno {
+		path = "/" + name
+	}
+	tl.Lock()
+	tl.lookups[path]++
+	tl.Unlock()
+	if name == "eio" {
+		return 0, syscall.EIO
+	}
+	if ino, ok := tl.inodes[path]; ok {
+		return ino, nil
+	}
+	return 0, syscall.ENOENT
+}
+
+func TestResolvePaths(t *testing.T) {
+	c := &client{dc: fs.NewDentryCache(), nc: newNegDentryCache(time.Hour, 16)}
+	tl := newTreeLookup("/a", "/a/b", "/a/b/f1", "/a/b/f2", "/a/c", "/a/c/f3", "/d", "/d/eio", "/d/eio/f4")
+
+	paths := []string{"/a/b/f1", "/a/b/f2", "/a/c/f3", "/a/b", "/", "/a/x/f5", "/a/x/f6", "/d/eio/f4", "/a/b/f1"}
+	inodes, errs := c.resolvePaths(paths, tl.lookup)
+	for i, p := range paths {
+		switch p {
+		case "/a/x/f5", "/a/x/f6":
+			require.Equal(t, syscall.ENOENT, errs[i], p)
+		case "/d/eio/f4":
+			require.Equal(t, syscall.EIO, errs[i], p)
+		default:
+			require.NoError(t, errs[i], p)
+			require.Equal(t, tl.inodes[p], inodes[i], p)
+		}
+	}
+	// each component is looked up once, and not below a failed one
+	for p, n := range tl.lookups {
+		require.Equal(t, 1, n, p)
+	}
+	require.Len(t, tl.lookups, 9)
+	require.True(t, c.nc.Has("/a/x"))
+	ino, ok := c.dc.Get("/a/b")
+	require.True(t, ok)
+	require.Equal(t, tl.inodes["/a/b"], ino)
+
+	// the cached dentries and the missing paths are not looked up again
+	tl.lookups = make(map[string]int)
+	paths = []string{"/a/b/f1", "/a/c/f3", "/a/x/f7", "/a/c/f8"}
+	inodes, errs = c.resolvePaths(paths, tl.lookup)
+	require.Equal(t, []uint64{tl.inodes["/a/b/f1"], tl.inodes["/a/c/f3"], 0, 0}, inodes)
+	require.Equal(t, []error{nil, nil, syscall.ENOENT, syscall.ENOENT}, errs)
+	require.Equal(t, map[string]int{"/a/c/f8": 1}, tl.lookups)
+}
+
+// fileContent reads content, the reads at failOffset fail.
+func fileContent(content []byte, failOffset int) func(offset int, data []byte) (int, error) {
+	return func(offset int, data []byte) (int, error) {
+		if offset == failOffset {
+			return 0, syscall.EIO
+		}
+		if offset >= len(content) {
+			return 0, nil
+		}
+		return copy(data, content[offset:]), nil
+	}
+}
+
+func TestReadVectors(t *testing.T) {
+	content := make([]byte, 100)
+	for i := range content {
+		content[i] = byte(i)
+	}
+	tests := []struct {
+		name       string
+		sizes      []int
+		offset     int
+		failOffset int
+		n          int
+		err        error
+	}{
+		{name: "split", sizes: []int{10, 0, 20, 5}, offset: 3, failOffset: -1, n: 35},
+		{name: "eof", sizes: []int{10, 20, 30}, offset: 60, failOffset: -1, n: 40},
+		{name: "at eof", sizes: []int{10, 20}, offset: 100, failOffset: -1, n: 0},
+		{name: "error", sizes: []int{10, 20}, offset: 0, failOffset: 0, err: syscall.EIO},
+		{name: "error after data", sizes: []int{10, 20, 30}, offset: 0, failOffset: 30, n: 30},
+		{name: "empty", sizes: []int{0}, offset: 0, failOffset: 0, n: 0},
+	}
+	for _, tt := range tests {
+		t.Run(tt.name, func(t *testing.T) {
+			bufs := make([][]byte, len(tt.sizes))
+			for i, size := range tt.sizes {
+				bufs[i] = bytes.Repeat([]byte{0xff}, size)
+			}
+			n, err := readVectors(bufs, tt.offset, fileContent(content, tt.failOffset))
+			require.Equal(t, tt.err, err)
+			require.Equal(t, tt.n, n)
+
+			// the buffers are filled in order, the ones past the end of the
+			// read are left untouched
+			left := n
+			offset := tt.offset
+			for _, buf := range bufs {
+				filled := len(buf)
+				if left < filled {
+					filled = left
+				}
+				require.Equal(t, content[offset:offset+filled], buf[:filled])
+				require.Equal(t, bytes.Repeat([]byte{0xff}, len(buf)-filled), buf[filled:])
+				left -= filled
+				offset += filled
+			}
+		})
+	}
+}
+
+func TestPreadBatch(t *testing.T) {
+	content := make([]byte, 100)
+	for i := range content {
+		content[i] = byte(i)
+	}
+	c := &client{fds: newFDTable(16)}
+	open := func(flags int) uint {
+		fd, ok := c.fds.alloc()
+		require.True(t, ok)
+		c.fds.store(fd, &file{fd: fd, ino: uint64(fd), flags: uint32(flags)})
+		return fd
+	}
+	rdonly, wronly, rdwr := open(syscall.O_RDONLY), open(syscall.O_WRONLY), open(syscall.O_RDWR)
+	read := func(f *file, offset int, data []byte) (int, error) {
+		return fileContent(content, 50)(offset, data)
+	}
+
+	reqs := []preadReq{
+		{fd: rdonly, offset: 0, data: make([]byte, 10)},
+		{fd: rdwr, offset: 95, data: make([]byte, 10)},
+		{fd: rdonly, offset: 100, data: make([]byte, 10)},
+		{fd: rdonly, offset: 50, data: make([]byte, 10)},
+		{fd: wronly, offset: 0, data: make([]byte, 10)},
+		{fd: 15, offset: 0, data: make([]byte, 10)},
+		{fd: rdonly, offset: 0, data: nil},
+		{fd: rdwr, offset: 20, data: make([]byte, 30)},
+	}
+	rets := []int{10, 5, 0, int(statusEIO), int(statusEACCES), int(statusEBADFD), 0, 30}
+	require.Equal(t, 5, c.preadBatch(reqs, read))
+	for i, req := range reqs {
+		require.Equal(t, rets[i], req.ret, "request %v", i)
+		if req.ret > 0 {
+			require.Equal(t, content[req.offset:req.offset+req.ret], req.data[:req.ret])
+		}
+	}
+}
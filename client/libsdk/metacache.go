@@ -0,0 +1,149 @@
+// Copyright 2024 The CubeFS Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+
+package main
+
+import (
+	"sync"
+	"time"
+
+	"github.com/cubefs/cubefs/client/fs"
+)
+
+// metaCacheConfig sets the sizes and the expirations of the metadata caches
+// of a client, zero values stand for the defaults.
+type metaCacheConfig struct {
+	icacheTimeout    time.Duration
+	icacheMaxEntries int
+	dcacheTimeout    time.Duration
+	scacheTimeout    time.Duration
+	scacheMaxEntries int
+
+	// the negative dentry cache is disabled if negDcacheTimeout is not positive
+	negDcacheTimeout    time.Duration
+	negDcacheMaxEntries int
+}
+
+type metaCache struct {
+	ic   *fs.InodeCache
+	dc   *fs.DentryCache
+	sc   *summaryTree
+	nc   *negDentryCache
+	refs int
+}
+
+func newMetaCache(cfg metaCacheConfig) *metaCache {
+	icacheTimeout := fs.DefaultInodeExpiration
+	if cfg.icacheTimeout > 0 {
+		icacheTimeout = cfg.icacheTimeout
+	}
+	icacheMaxEntries := fs.MaxInodeCache
+	if cfg.icacheMaxEntries > 0 {
+		icacheMaxEntries = cfg.icacheMaxEntries
+	}
+	dcacheTimeout := fs.DentryValidDuration
+	if cfg.dcacheTimeout > 0 {
+		dcacheTimeout = cfg.dcacheTimeout
+	}
+	scacheTimeout := fs.DefaultSummaryExpiration
+	if cfg.scacheTimeout > 0 {
+		scacheTimeout = cfg.scacheTimeout
+	}
+	scacheMaxEntries := fs.MaxSummaryCache
+	if cfg.scacheMaxEntries > 0 {
+		scacheMaxEntries = cfg.scacheMaxEntries
+	}
+	mc := &metaCache{
+		ic: fs.NewInodeCache(icacheTimeout, icacheMaxEntries),
+		dc: fs.NewDentryCacheWithExpiration(dcacheTimeout),
+		sc: newSummaryTree(scacheTimeout, scacheMaxEntries),
+	}
+	if cfg.negDcacheTimeout > 0 {
+		negDcacheMaxEntries := defaultNegDentryCacheMaxEntries
+		if cfg.negDcacheMaxEntries > 0 {
+			negDcacheMaxEntries = cfg.negDcacheMaxEntries
+		}
+		mc.nc = newNegDentryCache(cfg.negDcacheTimeout, negDcacheMaxEntries)
+	}
+	return mc
+}
+
+// close stops the background work of the caches.
+func (mc *metaCache) close() {
+	mc.ic.Stop()
+}
+
+// sharedMetaCaches holds the metadata caches shared by the clients of a
+// volume which enabled shareMetaCache. The settings of the first client
+// of a volume apply to its shared caches.
+var sharedMetaCaches = struct {
+	sync.Mutex
+	caches map[string]*metaCache
+}{caches: make(map[string]*metaCache)}
+
+func sharedMetaCacheKey(masterAddr, volName string) string {
+	return masterAddr + "/" + volName
+}
+
+func getSharedMetaCache(key string, cfg metaCacheConfig) *metaCache {
+	sharedMetaCaches.Lock()
+	defer sharedMetaCaches.Unlock()
+	mc, ok := sharedMetaCaches.caches[key]
+	if !ok {
+		mc = newMetaCache(cfg)
+		sharedMetaCaches.caches[key] = mc
+	}
+	mc.refs++
+	return mc
+}
+
+func putSharedMetaCache(key string) {
+	sharedMetaCaches.Lock()
+	defer sharedMetaCaches.Unlock()
+	mc, ok := sharedMetaCaches.caches[key]
+	if !ok {
+		return
+	}
+	if mc.refs--; mc.refs == 0 {
+		delete(sharedMetaCaches.caches, key)
+		mc.close()
+	}
+}
+
+// initMetaCache sets the metadata caches of c, shared with the other
+// clients of the volume if shareMetaCache is set.
+func (c *client) initMetaCache() {
+	if c.shareMetaCache {
+		c.sharedMetaCacheKey = sharedMetaCacheKey(c.masterAddr, c.volName)
+		c.metaCache = getSharedMetaCache(c.sharedMetaCacheKey, c.metaCacheCfg)
+	} else {
+		c.metaCache = newMetaCache(c.metaCacheCfg)
+	}
+	c.ic, c.dc, c.sc, c.nc = c.metaCache.ic, c.metaCache.dc, c.metaCache.sc, c.metaCache.nc
+}
+
+// releaseMetaCache releases the metadata caches of c, it does nothing if
+// they are already released.
+func (c *client) releaseMetaCache() {
+	if c.metaCache == nil {
+		return
+	}
+	if c.sharedMetaCacheKey != "" {
+		putSharedMetaCache(c.sharedMetaCacheKey)
+		c.sharedMetaCacheKey = ""
+	} else {
+		c.metaCache.close()
+	}
+	c.metaCache = nil
+}
@@ -0,0 +1,67 @@
+// Copyright 2024 The CubeFS Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+
+package main
+
+import (
+	"testing"
+
+	"github.com/stretchr/testify/require"
+)
+
+func TestSharedMetaCache(t *testing.T) {
+	key := sharedMetaCacheKey("master", "vol")
+	mc1 := getSharedMetaCache(key, metaCacheConfig{})
+	mc2 := getSharedMetaCache(key, metaCacheConfig{icacheMaxEntries: 1})
+	require.True(t, mc1 == mc2)
+	mc3 := getSharedMetaCache(sharedMetaCacheKey("master", "vol2"), metaCacheConfig{})
+	require.False(t, mc1 == mc3)
+
+	mc1.dc.Put("/a", 2)
+	ino, ok := mc2.dc.Get("/a")
+	require.True(t, ok)
+	require.EqualValues(t, 2, ino)
+
+	putSharedMetaCache(key)
+	require.True(t, getSharedMetaCache(key, metaCacheConfig{}) == mc1)
+	putSharedMetaCache(key)
+	putSharedMetaCache(key)
+	mc4 := getSharedMetaCache(key, metaCacheConfig{})
+	require.False(t, mc4 == mc1)
+	putSharedMetaCache(key)
+	putSharedMetaCache(sharedMetaCacheKey("master", "vol2"))
+	require.Empty(t, sharedMetaCaches.caches)
+}
+
+func TestClientMetaCache(t *testing.T) {
+	c1 := &client{masterAddr: "master", volName: "vol", shareMetaCache: true}
+	c2 := &client{masterAddr: "master", volName: "vol", shareMetaCache: true}
+	c1.initMetaCache()
+	c2.initMetaCache()
+	require.True(t, c1.ic == c2.ic)
+
+	// a client releases its reference once, e.g. when its start fails and
+	// it is closed afterwards
+	c1.releaseMetaCache()
+	c1.releaseMetaCache()
+	key := sharedMetaCacheKey("master", "vol")
+	require.Equal(t, 1, sharedMetaCaches.caches[key].refs)
+	c2.releaseMetaCache()
+	require.Empty(t, sharedMetaCaches.caches)
+
+	c3 := &client{}
+	c3.initMetaCache()
+	c3.releaseMetaCache()
+	require.Nil(t, c3.metaCache)
+}
@@ -0,0 +1,184 @@
+// Copyright 2024 The CubeFS Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+
+package main
+
+import (
+	"sync"
+	"syscall"
+
+	"github.com/cubefs/cubefs/util/log"
+)
+
+// mmapChunkSize is the unit in which a mapping is loaded, a multiple of the
+// page size.
+const mmapChunkSize = 1 << 20
+
+const (
+	chunkAbsent = iota
+	chunkLoading
+	chunkLoaded
+)
+
+type readFunc func(offset int, data []byte) (int, error)
+
+// roMapping maps a read-only file into anonymous memory. The pages are not
+// accessible until the chunks holding them are loaded by prefetch, so that
+// touching data which was never read faults instead of returning zeros.
+// Loaded chunks are plain memory shared by every thread of the process, and
+// a client maps a file once for all its fds.
+type roMapping struct {
+	sync.Mutex
+	cond   *sync.Cond
+	ino    uint64
+	size   int    // file size at map time
+	data   []byte // page aligned, len(data) >= size
+	read   readFunc
+	chunks []uint8
+
+	// guarded by client.mu
+	maps     int     // cfs_mmap_ro calls not yet undone, over all the fds
+	inflight int     // running prefetches
+	files    []*file // fds mapping the file
+}
+
+func newROMapping(ino uint64, size int, read readFunc) (*roMapping, error) {
+	data, err := syscall.Mmap(-1, 0, size, syscall.PROT_NONE, syscall.MAP_PRIVATE|syscall.MAP_ANON)
+	if err != nil {
+		return nil, err
+	}
+	m := &roMapping{
+		ino:    ino,
+		size:   size,
+		data:   data,
+		read:   read,
+		chunks: make([]uint8, (size+mmapChunkSize-1)/mmapChunkSize),
+	}
+	m.cond = sync.NewCond(&m.Mutex)
+	return m, nil
+}
+
+// prefetch loads the chunks overlapping [offset, offset+size) which are not
+// loaded yet, up to concurrency chunks at a time, and waits for the chunks
+// loaded meanwhile by other callers.
+func (m *roMapping) prefetch(offset, size, concurrency int) error {
+	if offset < 0 || size < 0 {
+		return syscall.EINVAL
+	}
+	if offset >= m.size || size == 0 {
+		return nil
+	}
+	end := offset + size
+	if end > m.size {
+		end = m.size
+	}
+	first, last := offset/mmapChunkSize, (end-1)/mmapChunkSize
+
+	var claimed, waiting []int
+	m.Lock()
+	for i := first; i <= last; i++ {
+		switch m.chunks[i] {
+		case chunkAbsent:
+			m.chunks[i] = chunkLoading
+			claimed = append(claimed, i)
+		case chunkLoading:
+			waiting = append(waiting, i)
+		}
+	}
+	m.Unlock()
+
+	var (
+		wg    sync.WaitGroup
+		errMu sync.Mutex
+		err   error
+	)
+	limit := make(chan struct{}, concurrency)
+	for _, i := range claimed {
+		wg.Add(1)
+		limit <- struct{}{}
+		go func(i int) {
+			defer func() {
+				<-limit
+				wg.Done()
+			}()
+			e := m.load(i)
+			m.Lock()
+			if e == nil {
+				m.chunks[i] = chunkLoaded
+			} else {
+				m.chunks[i] = chunkAbsent
+			}
+			m.cond.Broadcast()
+			m.Unlock()
+			if e != nil {
+				errMu.Lock()
+				err = e
+				errMu.Unlock()
+			}
+		}(i)
+	}
+	wg.Wait()
+	if err != nil {
+		return err
+	}
+
+	m.Lock()
+	defer m.Unlock()
+	for _, i := range waiting {
+		for m.chunks[i] == chunkLoading {
+			m.cond.Wait()
+		}
+		if m.chunks[i] != chunkLoaded {
+			// the other load failed
+			return syscall.EIO
+		}
+	}
+	return nil
+}
+
+func (m *roMapping) load(i int) error {
+	start := i * mmapChunkSize
+	end := start + mmapChunkSize
+	if end > len(m.data) {
+		end = len(m.data)
+	}
+	chunk := m.data[start:end]
+	if err := syscall.Mprotect(chunk, syscall.PROT_READ|syscall.PROT_WRITE); err != nil {
+		return err
+	}
+	want := m.size - start
+	if want > len(chunk) {
+		want = len(chunk)
+	}
+	for done := 0; done < want; {
+		n, err := m.read(start+done, chunk[done:want])
+		if err != nil || n == 0 {
+			log.LogErrorf("roMapping load: ino(%v) offset(%v) read(%v) err(%v)", m.ino, start+done, n, err)
+			syscall.Mprotect(chunk, syscall.PROT_NONE)
+			if err == nil {
+				err = syscall.EIO
+			}
+			return err
+		}
+		done += n
+	}
+	return syscall.Mprotect(chunk, syscall.PROT_READ)
+}
+
+func (m *roMapping) unmap() {
+	if err := syscall.Munmap(m.data); err != nil {
+		log.LogErrorf("roMapping unmap: ino(%v) err(%v)", m.ino, err)
+	}
+	m.data = nil
+}
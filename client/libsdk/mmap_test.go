@@ -0,0 +1,147 @@
+// Copyright 2024 The CubeFS Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+
+package main
+
+import (
+	"bytes"
+	"sync"
+	"sync/atomic"
+	"syscall"
+	"testing"
+
+	"github.com/stretchr/testify/require"
+)
+
+func TestROMapping(t *testing.T) {
+	content := make([]byte, 3*mmapChunkSize+12345)
+	for i := range content {
+		content[i] = byte(i * 7)
+	}
+	var reads int32
+	m, err := newROMapping(1, len(content), func(offset int, data []byte) (int, error) {
+		atomic.AddInt32(&reads, 1)
+		// short reads are retried
+		if len(data) > 4096 {
+			data = data[:4096]
+		}
+		return copy(data, content[offset:]), nil
+	})
+	require.NoError(t, err)
+	defer m.unmap()
+
+	var wg sync.WaitGroup
+	for i := 0; i < 8; i++ {
+		wg.Add(1)
+		go func() {
+			defer wg.Done()
+			require.NoError(t, m.prefetch(mmapChunkSize+1, 2*mmapChunkSize, 4))
+		}()
+	}
+	wg.Wait()
+	// each of the chunks 1, 2 and 3 was loaded once
+	require.Equal(t, int32((2*mmapChunkSize+12345+4095)/4096), reads)
+	require.True(t, bytes.Equal(content[mmapChunkSize:], m.data[mmapChunkSize:]))
+
+	require.NoError(t, m.prefetch(0, len(content)*2, 4))
+	require.True(t, bytes.Equal(content, m.data))
+	require.Equal(t, syscall.EINVAL, m.prefetch(-1, 1, 4))
+}
+
+func TestROMappingError(t *testing.T) {
+	fail := true
+	m, err := newROMapping(1, 2*mmapChunkSize, func(offset int, data []byte) (int, error) {
+		if fail {
+			return 0, syscall.EIO
+		}
+		return len(data), nil
+	})
+	require.NoError(t, err)
+	defer m.unmap()
+
+	require.Equal(t, syscall.EIO, m.prefetch(0, 1, 4))
+	require.Equal(t, uint8(chunkAbsent), m.chunks[0])
+
+	// the failed chunk is loaded again
+	fail = false
+	require.NoError(t, m.prefetch(0, 1, 4))
+	require.Equal(t, uint8(chunkLoaded), m.chunks[0])
+	require.Equal(t, uint8(chunkAbsent), m.chunks[1])
+}
+
+func TestClientMappings(t *testing.T) {
+	c := &client{mappings: make(map[uint64]*roMapping)}
+	m, err := newROMapping(1, 2*mmapChunkSize, func(offset int, data []byte) (int, error) {
+		return len(data), nil
+	})
+	require.NoError(t, err)
+	c.mappings[1] = m
+	f1, f2 := &file{ino: 1}, &file{ino: 1}
+
+	// the fds of the same file share its mapping
+	for _, f := range []*file{f1, f1, f2} {
+		fm, err := c.mmapRO(f)
+		require.NoError(t, err)
+		require.Equal(t, m, fm)
+	}
+	require.Equal(t, 3, m.maps)
+	require.Equal(t, []*file{f1, f2}, m.files)
+
+	// the mapping outlives the fd unmapping it
+	require.True(t, c.munmap(f1, true))
+	require.Nil(t, f1.mmap)
+	require.False(t, c.munmap(f1, false))
+	require.Equal(t, []*file{f2}, m.files)
+	require.NotNil(t, m.data)
+
+	// and the last unmap waits for the prefetches in progress
+	require.Equal(t, m, c.getMapping(f2))
+	require.True(t, c.munmap(f2, false))
+	require.NotNil(t, m.data)
+	require.Equal(t, m, c.mappings[1])
+	c.putMapping(m)
+	require.Nil(t, m.data)
+	require.Empty(t, c.mappings)
+
+	// a mapping without fd can't be loaded
+	_, err = c.readMapping(m, 0, make([]byte, 1))
+	require.Equal(t, syscall.EBADF, err)
+}
+
+func TestClientReleaseMappings(t *testing.T) {
+	c := &client{mappings: make(map[uint64]*roMapping)}
+	var ms []*roMapping
+	for ino := uint64(1); ino <= 2; ino++ {
+		m, err := newROMapping(ino, mmapChunkSize, nil)
+		require.NoError(t, err)
+		c.mappings[ino] = m
+		ms = append(ms, m)
+	}
+	f1, f2 := &file{ino: 1}, &file{ino: 2}
+	_, err := c.mmapRO(f1)
+	require.NoError(t, err)
+	_, err = c.mmapRO(f2)
+	require.NoError(t, err)
+	c.getMapping(f2)
+
+	c.releaseMappings()
+	require.Empty(t, c.mappings)
+	require.Nil(t, f1.mmap)
+	require.Nil(t, f2.mmap)
+	require.Nil(t, ms[0].data)
+	// the mapping in use is unmapped once the prefetch returns
+	require.NotNil(t, ms[1].data)
+	c.putMapping(ms[1])
+	require.Nil(t, ms[1].data)
+}
@@ -0,0 +1,118 @@
+// Copyright 2024 The CubeFS Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+
+package main
+
+import (
+	"container/list"
+	"strings"
+	"sync"
+	"time"
+)
+
+const defaultNegDentryCacheMaxEntries = 65536
+
+type negDentry struct {
+	path   string
+	expire time.Time
+}
+
+// negDentryCache remembers the paths which were not found, so that probing
+// a missing file again doesn't cost a lookup on the meta nodes. The entries
+// expire after a short time, since files created by other clients are not
+// seen meanwhile, and are dropped when the path is created through libsdk.
+// A nil cache is disabled.
+type negDentryCache struct {
+	sync.Mutex
+	ttl        time.Duration
+	maxEntries int
+	entries    map[string]*list.Element
+	lruList    *list.List // front is the newest
+}
+
+func newNegDentryCache(ttl time.Duration, maxEntries int) *negDentryCache {
+	return &negDentryCache{
+		ttl:        ttl,
+		maxEntries: maxEntries,
+		entries:    make(map[string]*list.Element),
+		lruList:    list.New(),
+	}
+}
+
+func (nc *negDentryCache) Put(path string) {
+	if nc == nil {
+		return
+	}
+	nc.Lock()
+	defer nc.Unlock()
+	if elem, ok := nc.entries[path]; ok {
+		nc.lruList.Remove(elem)
+		delete(nc.entries, path)
+	}
+	for nc.lruList.Len() >= nc.maxEntries {
+		nc.remove(nc.lruList.Back())
+	}
+	nc.entries[path] = nc.lruList.PushFront(&negDentry{path: path, expire: time.Now().Add(nc.ttl)})
+}
+
+// Has returns true if the path is known not to exist.
+func (nc *negDentryCache) Has(path string) bool {
+	if nc == nil {
+		return false
+	}
+	nc.Lock()
+	defer nc.Unlock()
+	elem, ok := nc.entries[path]
+	if !ok {
+		return false
+	}
+	if elem.Value.(*negDentry).expire.Before(time.Now()) {
+		nc.remove(elem)
+		return false
+	}
+	return true
+}
+
+// Delete drops the path, it's called once the path is created.
+func (nc *negDentryCache) Delete(path string) {
+	if nc == nil {
+		return
+	}
+	nc.Lock()
+	defer nc.Unlock()
+	if elem, ok := nc.entries[path]; ok {
+		nc.remove(elem)
+	}
+}
+
+// DeleteTree drops the path and all the paths below it, it's called when a
+// directory may appear at path, e.g. as the target of a rename.
+func (nc *negDentryCache) DeleteTree(path string) {
+	if nc == nil {
+		return
+	}
+	prefix := strings.TrimSuffix(path, "/") + "/"
+	nc.Lock()
+	defer nc.Unlock()
+	for p, elem := range nc.entries {
+		if p == path || strings.HasPrefix(p, prefix) {
+			nc.remove(elem)
+		}
+	}
+}
+
+func (nc *negDentryCache) remove(elem *list.Element) {
+	nc.lruList.Remove(elem)
+	delete(nc.entries, elem.Value.(*negDentry).path)
+}
@@ -0,0 +1,53 @@
+// Copyright 2024 The CubeFS Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+
+package main
+
+import (
+	"testing"
+	"time"
+
+	"github.com/stretchr/testify/require"
+)
+
+func TestNegDentryCache(t *testing.T) {
+	nc := newNegDentryCache(time.Hour, 3)
+	nc.Put("/a")
+	nc.Put("/d/x")
+	nc.Put("/d/y/z")
+	require.True(t, nc.Has("/a"))
+
+	// the oldest entry is evicted
+	nc.Put("/dd")
+	require.False(t, nc.Has("/a"))
+	require.True(t, nc.Has("/dd"))
+
+	nc.DeleteTree("/d")
+	require.False(t, nc.Has("/d/x"))
+	require.False(t, nc.Has("/d/y/z"))
+	require.True(t, nc.Has("/dd"))
+
+	nc.Delete("/dd")
+	require.False(t, nc.Has("/dd"))
+
+	nc = newNegDentryCache(time.Millisecond, 3)
+	nc.Put("/a")
+	time.Sleep(2 * time.Millisecond)
+	require.False(t, nc.Has("/a"))
+
+	// a nil cache is disabled
+	nc = nil
+	nc.Put("/a")
+	require.False(t, nc.Has("/a"))
+}
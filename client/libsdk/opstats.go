@@ -0,0 +1,239 @@
+// Copyright 2024 The CubeFS Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+
+package main
+
+import (
+	"fmt"
+	"io"
+	"math/bits"
+	"net"
+	"net/http"
+	"sync/atomic"
+	"time"
+
+	"github.com/cubefs/cubefs/util/log"
+)
+
+type opType int
+
+const (
+	opGetattr opType = iota
+	opStatPaths
+	opSetattr
+	opOpen
+	opFlush
+	opClose
+	opTruncate
+	opWrite
+	opWritev
+	opRead
+	opReadv
+	opPreadBatch
+	opMmapRO
+	opMmapPrefetch
+	opMunmap
+	opAioSetup
+	opAioSubmit
+	opAioGetevents
+	opAioDestroy
+	opBatchGetInodes
+	opReaddir
+	opLsdir
+	opMkdirs
+	opRmdir
+	opUnlink
+	opRename
+	opFchmod
+	opSymlink
+	opLink
+	opGetSummary
+	opRefreshSummary
+	opGetXattr
+	opChdir
+	opGetcwd
+	opGetDirLock
+	opLockDir
+	opUnlockDir
+	opListVols
+	opGetAccessFiles
+	numOps
+)
+
+var opNames = [numOps]string{
+	"getattr", "stat_paths", "setattr", "open", "flush", "close", "truncate",
+	"write", "writev", "read", "readv", "pread_batch", "mmap_ro",
+	"mmap_prefetch", "munmap", "aio_setup", "aio_submit", "aio_getevents",
+	"aio_destroy", "batch_get_inodes", "readdir", "lsdir", "mkdirs", "rmdir",
+	"unlink", "rename", "fchmod", "symlink", "link", "getsummary",
+	"refreshsummary", "get_xattr", "chdir", "getcwd", "get_dir_lock",
+	"lock_dir", "unlock_dir", "list_vols", "get_accessFiles",
+}
+
+const (
+	// every power of two of nanoseconds is split into latencySubs buckets,
+	// which bounds the relative error of a percentile to 25%
+	latencySubBits = 2
+	latencySubs    = 1 << latencySubBits
+	latencyBuckets = 64 * latencySubs
+
+	opStatShards = 4
+)
+
+type latencyHist struct {
+	buckets [latencyBuckets]uint64
+	count   uint64
+	sum     uint64
+	max     uint64
+}
+
+func latencyIndex(ns uint64) int {
+	if ns < latencySubs {
+		return int(ns)
+	}
+	msb := bits.Len64(ns) - 1
+	return (msb-latencySubBits+1)*latencySubs + int((ns>>(msb-latencySubBits))&(latencySubs-1))
+}
+
+// latencyUpper returns the largest latency of bucket i.
+func latencyUpper(i int) uint64 {
+	if i < latencySubs {
+		return uint64(i)
+	}
+	msb := i/latencySubs + latencySubBits - 1
+	return (uint64(latencySubs+i%latencySubs+1) << (msb - latencySubBits)) - 1
+}
+
+func (h *latencyHist) add(ns uint64) {
+	atomic.AddUint64(&h.buckets[latencyIndex(ns)], 1)
+	atomic.AddUint64(&h.count, 1)
+	atomic.AddUint64(&h.sum, ns)
+	for {
+		max := atomic.LoadUint64(&h.max)
+		if ns <= max || atomic.CompareAndSwapUint64(&h.max, max, ns) {
+			return
+		}
+	}
+}
+
+func (h *latencyHist) merge(o *latencyHist) {
+	for i := range o.buckets {
+		h.buckets[i] += atomic.LoadUint64(&o.buckets[i])
+	}
+	h.count += atomic.LoadUint64(&o.count)
+	h.sum += atomic.LoadUint64(&o.sum)
+	if max := atomic.LoadUint64(&o.max); max > h.max {
+		h.max = max
+	}
+}
+
+// percentile returns the upper bound of the bucket holding the p-th
+// percentile, p in [0, 100].
+func (h *latencyHist) percentile(p float64) uint64 {
+	rank := uint64(p / 100 * float64(h.count))
+	var seen uint64
+	for i, n := range h.buckets {
+		if seen += n; seen > rank {
+			if upper := latencyUpper(i); upper < h.max {
+				return upper
+			}
+			break
+		}
+	}
+	return h.max
+}
+
+// opStats keeps a latency histogram per exported operation. The updates are
+// lock free and spread over a few shards, picked by the low bits of the
+// latency, so that concurrent callers rarely touch the same cache lines.
+type opStats struct {
+	hists [numOps][opStatShards]latencyHist
+}
+
+func (s *opStats) done(op opType, start time.Time) {
+	ns := uint64(time.Since(start))
+	s.hists[op][ns%opStatShards].add(ns)
+}
+
+func (s *opStats) snapshot(op opType) *latencyHist {
+	h := &latencyHist{}
+	for i := range s.hists[op] {
+		h.merge(&s.hists[op][i])
+	}
+	return h
+}
+
+// writeText writes a line per operation called so far, with the latencies
+// in microseconds.
+func (s *opStats) writeText(w io.Writer) {
+	for op := opType(0); op < numOps; op++ {
+		h := s.snapshot(op)
+		if h.count == 0 {
+			continue
+		}
+		fmt.Fprintf(w, "%s count=%d avg_us=%.1f p50_us=%.1f p90_us=%.1f p99_us=%.1f p999_us=%.1f max_us=%.1f\n",
+			opNames[op], h.count, float64(h.sum)/float64(h.count)/1e3,
+			float64(h.percentile(50))/1e3, float64(h.percentile(90))/1e3, float64(h.percentile(99))/1e3,
+			float64(h.percentile(99.9))/1e3, float64(h.max)/1e3)
+	}
+}
+
+// writePrometheus writes the histograms in the Prometheus text format, with
+// a bucket per power of two of nanoseconds from 1us to 64s.
+func (s *opStats) writePrometheus(w io.Writer, vol string) {
+	const name = "cfs_libsdk_op_latency_seconds"
+	fmt.Fprintf(w, "# TYPE %s histogram\n", name)
+	for op := opType(0); op < numOps; op++ {
+		h := s.snapshot(op)
+		if h.count == 0 {
+			continue
+		}
+		var cumulative uint64
+		for i, n := range h.buckets {
+			cumulative += n
+			upper := latencyUpper(i)
+			if (i+1)%latencySubs != 0 || upper < 1<<10 {
+				continue
+			}
+			fmt.Fprintf(w, "%s_bucket{vol=%q,op=%q,le=\"%g\"} %d\n", name, vol, opNames[op],
+				float64(upper+1)/1e9, cumulative)
+			if upper >= 1<<36-1 {
+				break
+			}
+		}
+		fmt.Fprintf(w, "%s_bucket{vol=%q,op=%q,le=\"+Inf\"} %d\n", name, vol, opNames[op], h.count)
+		fmt.Fprintf(w, "%s_sum{vol=%q,op=%q} %g\n", name, vol, opNames[op], float64(h.sum)/1e9)
+		fmt.Fprintf(w, "%s_count{vol=%q,op=%q} %d\n", name, vol, opNames[op], h.count)
+	}
+}
+
+// serveStats serves the histograms of the client at http://addr/metrics.
+func (c *client) serveStats(addr string) (*http.Server, error) {
+	ln, err := net.Listen("tcp", addr)
+	if err != nil {
+		return nil, err
+	}
+	mux := http.NewServeMux()
+	mux.HandleFunc("/metrics", func(w http.ResponseWriter, r *http.Request) {
+		w.Header().Set("Content-Type", "text/plain; version=0.0.4")
+		c.stats.writePrometheus(w, c.volName)
+	})
+	server := &http.Server{Handler: mux}
+	go func() {
+		if err := server.Serve(ln); err != nil && err != http.ErrServerClosed {
+			log.LogErrorf("serveStats: addr(%v) err(%v)", addr, err)
+		}
+	}()
+	return server, nil
+}
@@ -0,0 +1,75 @@
+// Copyright 2024 The CubeFS Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+
+package main
+
+import (
+	"strings"
+	"testing"
+	"time"
+
+	"github.com/stretchr/testify/require"
+)
+
+func TestLatencyBuckets(t *testing.T) {
+	prev := -1
+	for _, ns := range []uint64{0, 1, 3, 4, 5, 7, 8, 1000, 1023, 1024, 123456789, 1 << 40, ^uint64(0)} {
+		i := latencyIndex(ns)
+		require.Less(t, i, latencyBuckets)
+		require.GreaterOrEqual(t, i, prev)
+		require.GreaterOrEqual(t, latencyUpper(i), ns)
+		if i > 0 {
+			require.Less(t, latencyUpper(i-1), ns)
+		}
+		prev = i
+	}
+}
+
+func TestOpStats(t *testing.T) {
+	s := &opStats{}
+	h := &s.hists[opRead][0]
+	for i := 1; i <= 1000; i++ {
+		h.add(uint64(i) * uint64(time.Microsecond))
+	}
+	s.done(opWrite, time.Now())
+
+	snap := s.snapshot(opRead)
+	require.Equal(t, uint64(1000), snap.count)
+	require.Equal(t, uint64(time.Millisecond), snap.max)
+	p50 := snap.percentile(50)
+	require.True(t, p50 >= 500*uint64(time.Microsecond) && p50 < 640*uint64(time.Microsecond), "p50 %v", p50)
+	require.Equal(t, snap.max, snap.percentile(100))
+
+	var sb strings.Builder
+	s.writeText(&sb)
+	lines := strings.Split(strings.TrimSpace(sb.String()), "\n")
+	require.Len(t, lines, 2)
+	require.True(t, strings.HasPrefix(lines[0], "write count=1 "))
+	require.True(t, strings.HasPrefix(lines[1], "read count=1000 avg_us=500.5 "))
+
+	sb.Reset()
+	s.writePrometheus(&sb, "vol")
+	require.Contains(t, sb.String(), `cfs_libsdk_op_latency_seconds_bucket{vol="vol",op="read",le="+Inf"} 1000`)
+	require.Contains(t, sb.String(), `cfs_libsdk_op_latency_seconds_bucket{vol="vol",op="read",le="0.001048576"} 1000`)
+	require.Contains(t, sb.String(), `cfs_libsdk_op_latency_seconds_count{vol="vol",op="write"} 1`)
+}
+
+func BenchmarkOpStatsDone(b *testing.B) {
+	s := &opStats{}
+	b.RunParallel(func(pb *testing.PB) {
+		for pb.Next() {
+			s.done(opRead, time.Now())
+		}
+	})
+}
@@ -0,0 +1,158 @@
+// Copyright 2024 The CubeFS Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+
+package main
+
+import (
+	gopath "path"
+	"strings"
+	"sync"
+	"time"
+
+	"github.com/cubefs/cubefs/proto"
+	"github.com/cubefs/cubefs/sdk/meta"
+)
+
+type summaryEntry struct {
+	info   meta.SummaryInfo
+	expire int64
+}
+
+// summaryTree caches the content summaries computed by GetSummary_ll by
+// directory path. Since a summary covers the whole subtree, the files and
+// directories created or removed through libsdk are applied to the cached
+// summaries of every ancestor, which keeps them usable without walking the
+// tree again. The changes whose effect is unknown, such as renames and
+// truncates, drop the summaries they affect. An entry expires after a
+// while, so that the changes done by other clients are reconciled by a new
+// walk.
+type summaryTree struct {
+	sync.Mutex
+	entries    map[string]*summaryEntry
+	expiration time.Duration
+	maxEntries int
+}
+
+func newSummaryTree(exp time.Duration, maxEntries int) *summaryTree {
+	return &summaryTree{
+		entries:    make(map[string]*summaryEntry),
+		expiration: exp,
+		maxEntries: maxEntries,
+	}
+}
+
+func (st *summaryTree) Get(path string) (meta.SummaryInfo, bool) {
+	st.Lock()
+	defer st.Unlock()
+	e, ok := st.entries[path]
+	if !ok || time.Now().UnixNano() > e.expire {
+		return meta.SummaryInfo{}, false
+	}
+	return e.info, true
+}
+
+func (st *summaryTree) Put(path string, info meta.SummaryInfo) {
+	st.Lock()
+	defer st.Unlock()
+	if _, ok := st.entries[path]; !ok && len(st.entries) >= st.maxEntries {
+		now := time.Now().UnixNano()
+		for p, e := range st.entries {
+			if now > e.expire {
+				delete(st.entries, p)
+			}
+		}
+		if len(st.entries) >= st.maxEntries {
+			st.entries = make(map[string]*summaryEntry)
+		}
+	}
+	st.entries[path] = &summaryEntry{info: info, expire: time.Now().Add(st.expiration).UnixNano()}
+}
+
+// Add applies delta, a change of the directory dir, to the summaries of dir
+// and of its ancestors.
+func (st *summaryTree) Add(dir string, delta meta.SummaryInfo) {
+	st.Lock()
+	defer st.Unlock()
+	for p := dir; ; p = gopath.Dir(p) {
+		if e, ok := st.entries[p]; ok {
+			e.info.Subdirs += delta.Subdirs
+			e.info.FilesHdd += delta.FilesHdd
+			e.info.FilesSsd += delta.FilesSsd
+			e.info.FilesBlobStore += delta.FilesBlobStore
+			e.info.FbytesHdd += delta.FbytesHdd
+			e.info.FbytesSsd += delta.FbytesSsd
+			e.info.FbytesBlobStore += delta.FbytesBlobStore
+		}
+		if p == "/" {
+			return
+		}
+	}
+}
+
+// Invalidate drops the summaries of dir and of its ancestors.
+func (st *summaryTree) Invalidate(dir string) {
+	st.Lock()
+	defer st.Unlock()
+	st.invalidate(dir)
+}
+
+// InvalidateTree drops the summaries of path, of its ancestors and of
+// everything below it.
+func (st *summaryTree) InvalidateTree(path string) {
+	prefix := strings.TrimSuffix(path, "/") + "/"
+	st.Lock()
+	defer st.Unlock()
+	st.invalidate(path)
+	for p := range st.entries {
+		if strings.HasPrefix(p, prefix) {
+			delete(st.entries, p)
+		}
+	}
+}
+
+func (st *summaryTree) invalidate(dir string) {
+	for p := dir; ; p = gopath.Dir(p) {
+		delete(st.entries, p)
+		if p == "/" {
+			return
+		}
+	}
+}
+
+// summaryDelta returns the change of the summary of the parent directory
+// when info is created or, if removed is set, removed. It mirrors the
+// updates of the summary xattrs done by the MetaWrapper.
+func summaryDelta(info *proto.InodeInfo, removed bool) (delta meta.SummaryInfo) {
+	sign := int64(1)
+	if removed {
+		sign = -1
+	}
+	if proto.IsDir(info.Mode) {
+		delta.Subdirs = sign
+		return
+	}
+	var size int64
+	if removed {
+		size = -int64(info.Size)
+	}
+	switch info.StorageClass {
+	case proto.StorageClass_Replica_HDD:
+		delta.FilesHdd, delta.FbytesHdd = sign, size
+	case proto.StorageClass_Replica_SSD:
+		delta.FilesSsd, delta.FbytesSsd = sign, size
+	case proto.StorageClass_BlobStore:
+		delta.FilesBlobStore, delta.FbytesBlobStore = sign, size
+	}
+	return
+}
@@ -0,0 +1,72 @@
+// Copyright 2024 The CubeFS Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+
+package main
+
+import (
+	"os"
+	"testing"
+	"time"
+
+	"github.com/cubefs/cubefs/proto"
+	"github.com/cubefs/cubefs/sdk/meta"
+	"github.com/stretchr/testify/require"
+)
+
+func TestSummaryTree(t *testing.T) {
+	st := newSummaryTree(time.Minute, 100)
+	st.Put("/", meta.SummaryInfo{Subdirs: 2, FilesHdd: 10, FbytesHdd: 1000})
+	st.Put("/a", meta.SummaryInfo{Subdirs: 1, FilesHdd: 4, FbytesHdd: 400})
+	st.Put("/b", meta.SummaryInfo{FilesHdd: 6, FbytesHdd: 600})
+
+	file := &proto.InodeInfo{Mode: 0o644, Size: 100, StorageClass: proto.StorageClass_Replica_HDD}
+	st.Add("/a/c", summaryDelta(file, false))
+	st.Add("/a", summaryDelta(&proto.InodeInfo{Mode: proto.Mode(os.ModeDir | 0o755)}, false))
+	st.Add("/b", summaryDelta(file, true))
+
+	info, ok := st.Get("/")
+	require.True(t, ok)
+	require.Equal(t, meta.SummaryInfo{Subdirs: 3, FilesHdd: 10, FbytesHdd: 900}, info)
+	info, _ = st.Get("/a")
+	require.Equal(t, meta.SummaryInfo{Subdirs: 2, FilesHdd: 5, FbytesHdd: 400}, info)
+	info, _ = st.Get("/b")
+	require.Equal(t, meta.SummaryInfo{FilesHdd: 5, FbytesHdd: 500}, info)
+
+	// a rename drops the summaries of both sides and of the moved tree
+	st.Put("/b/d", meta.SummaryInfo{})
+	st.InvalidateTree("/b")
+	for _, p := range []string{"/", "/b", "/b/d"} {
+		_, ok = st.Get(p)
+		require.False(t, ok, p)
+	}
+	_, ok = st.Get("/a")
+	require.True(t, ok)
+}
+
+func TestSummaryTreeLimit(t *testing.T) {
+	st := newSummaryTree(time.Millisecond, 2)
+	st.Put("/a", meta.SummaryInfo{})
+	st.Put("/b", meta.SummaryInfo{})
+	time.Sleep(2 * time.Millisecond)
+	_, ok := st.Get("/a")
+	require.False(t, ok)
+
+	// expired entries make room first
+	st.expiration = time.Minute
+	st.Put("/c", meta.SummaryInfo{})
+	require.Len(t, st.entries, 1)
+	st.Put("/d", meta.SummaryInfo{})
+	st.Put("/e", meta.SummaryInfo{})
+	require.Len(t, st.entries, 1)
+}
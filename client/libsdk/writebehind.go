@@ -0,0 +1,160 @@
+// Copyright 2024 The CubeFS Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+
+package main
+
+import (
+	"io"
+	"sync"
+	"time"
+
+	"github.com/cubefs/cubefs/util"
+	"github.com/cubefs/cubefs/util/log"
+)
+
+type writeFunc func(offset int, data []byte) (int, error)
+
+// writeBehind coalesces the small adjacent writes of a file into writes of
+// util.BlockSize bytes, it's shared by the descriptors of the file opened
+// for write. The buffered data is written out when the buffer is full, when
+// a write is not adjacent to it, after the flush delay, and before any read,
+// stat, truncate, flush or close of the file.
+//
+// A write returns once its data is buffered, so the data is only durable
+// after cfs_flush or cfs_close. An error of a background write out, or of a
+// write out for a reader, is returned by the next write or flush of a
+// writer. The data a failed write out left unwritten stays buffered, and is
+// written by the next one.
+type writeBehind struct {
+	sync.Mutex
+	ino    uint64
+	write  writeFunc
+	delay  time.Duration
+	buf    []byte
+	offset int // file offset of buf[0]
+	timer  *time.Timer
+	armed  bool // the timer is pending
+	err    error
+	refs   int // descriptors sharing the buffer, guarded by client.wbMu
+}
+
+func newWriteBehind(ino uint64, delay time.Duration, write writeFunc) *writeBehind {
+	return &writeBehind{
+		ino:   ino,
+		write: write,
+		delay: delay,
+		buf:   make([]byte, 0, util.BlockSize),
+	}
+}
+
+// Write buffers data if it's smaller than the buffer, and writes it
+// straight through otherwise.
+func (wb *writeBehind) Write(offset int, data []byte) (n int, err error) {
+	wb.Lock()
+	defer wb.Unlock()
+	if err = wb.takeErr(); err != nil {
+		return
+	}
+
+	if len(wb.buf) > 0 && (offset != wb.offset+len(wb.buf) || len(wb.buf)+len(data) > cap(wb.buf)) {
+		if err = wb.flush(); err != nil {
+			return
+		}
+	}
+	if len(data) >= cap(wb.buf) {
+		return wb.write(offset, data)
+	}
+
+	if len(wb.buf) == 0 {
+		wb.offset = offset
+	}
+	if !wb.armed {
+		if wb.timer == nil {
+			wb.timer = time.AfterFunc(wb.delay, wb.backgroundFlush)
+		} else {
+			wb.timer.Reset(wb.delay)
+		}
+		wb.armed = true
+	}
+	wb.buf = append(wb.buf, data...)
+	if len(wb.buf) == cap(wb.buf) {
+		if err = wb.flush(); err != nil {
+			return
+		}
+	}
+	return len(data), nil
+}
+
+// Flush writes out the buffered data.
+func (wb *writeBehind) Flush() error {
+	wb.Lock()
+	defer wb.Unlock()
+	if err := wb.takeErr(); err != nil {
+		return err
+	}
+	return wb.flush()
+}
+
+// WriteOut writes out the buffered data for a reader of the file, its error
+// is kept for the writers. It returns whether data was buffered.
+func (wb *writeBehind) WriteOut() bool {
+	wb.Lock()
+	defer wb.Unlock()
+	if len(wb.buf) == 0 {
+		return false
+	}
+	if wb.err == nil {
+		wb.err = wb.flush()
+	}
+	return true
+}
+
+func (wb *writeBehind) backgroundFlush() {
+	wb.Lock()
+	defer wb.Unlock()
+	wb.armed = false
+	if wb.err == nil {
+		wb.err = wb.flush()
+	}
+}
+
+// flush must be called with the lock held.
+func (wb *writeBehind) flush() error {
+	if len(wb.buf) == 0 {
+		return nil
+	}
+	if wb.armed {
+		wb.timer.Stop()
+		wb.armed = false
+	}
+	n, err := wb.write(wb.offset, wb.buf)
+	if err == nil && n < len(wb.buf) {
+		err = io.ErrShortWrite
+	}
+	if err != nil {
+		log.LogErrorf("writeBehind: ino(%v) offset(%v) size(%v) written(%v) err(%v)", wb.ino, wb.offset, len(wb.buf), n, err)
+		if n > 0 && n < len(wb.buf) {
+			wb.offset += n
+			wb.buf = wb.buf[:copy(wb.buf, wb.buf[n:])]
+		}
+		return err
+	}
+	wb.buf = wb.buf[:0]
+	return nil
+}
+
+func (wb *writeBehind) takeErr() (err error) {
+	err, wb.err = wb.err, nil
+	return
+}
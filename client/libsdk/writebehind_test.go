@@ -0,0 +1,224 @@
+// Copyright 2024 The CubeFS Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+
+package main
+
+import (
+	"io"
+	"net"
+	"sync"
+	"syscall"
+	"testing"
+	"time"
+
+	"github.com/cubefs/cubefs/proto"
+	"github.com/cubefs/cubefs/util"
+	"github.com/stretchr/testify/require"
+)
+
+type fakeFile struct {
+	sync.Mutex
+	data   []byte
+	writes int
+	err    error
+	limit  int // bytes written per write if set
+}
+
+func (ff *fakeFile) write(offset int, data []byte) (int, error) {
+	ff.Lock()
+	defer ff.Unlock()
+	if ff.err != nil {
+		return 0, ff.err
+	}
+	ff.writes++
+	if ff.limit > 0 && len(data) > ff.limit {
+		data = data[:ff.limit]
+	}
+	if end := offset + len(data); end > len(ff.data) {
+		ff.data = append(ff.data, make([]byte, end-len(ff.data))...)
+	}
+	copy(ff.data[offset:], data)
+	return len(data), nil
+}
+
+func TestWriteBehind(t *testing.T) {
+	ff := &fakeFile{}
+	wb := newWriteBehind(1, time.Hour, ff.write)
+	record := make([]byte, 512)
+
+	// adjacent writes are coalesced into full blocks
+	for i := 0; i < 2*util.BlockSize/len(record); i++ {
+		record[0] = byte(i)
+		n, err := wb.Write(i*len(record), record)
+		require.NoError(t, err)
+		require.Equal(t, len(record), n)
+	}
+	require.Equal(t, 2, ff.writes)
+	require.Equal(t, byte(1), ff.data[len(record)])
+
+	// a write elsewhere writes out the buffer first
+	_, err := wb.Write(2*util.BlockSize, record)
+	require.NoError(t, err)
+	_, err = wb.Write(0, record)
+	require.NoError(t, err)
+	require.Equal(t, 3, ff.writes)
+	require.NoError(t, wb.Flush())
+	require.Equal(t, 4, ff.writes)
+
+	// large writes go through
+	_, err = wb.Write(0, make([]byte, util.BlockSize))
+	require.NoError(t, err)
+	require.Equal(t, 5, ff.writes)
+}
+
+func TestWriteBehindBackgroundFlush(t *testing.T) {
+	ff := &fakeFile{err: syscall.EIO}
+	wb := newWriteBehind(1, time.Millisecond, ff.write)
+	_, err := wb.Write(0, make([]byte, 512))
+	require.NoError(t, err)
+	time.Sleep(20 * time.Millisecond)
+
+	// the error of the background flush is returned, and the data is kept
+	// for the next flush
+	require.Equal(t, syscall.EIO, wb.Flush())
+	require.Equal(t, syscall.EIO, wb.Flush())
+	ff.Lock()
+	ff.err = nil
+	ff.Unlock()
+	require.NoError(t, wb.Flush())
+	require.Equal(t, 1, ff.writes)
+	require.Equal(t, 512, len(ff.data))
+
+	_, err = wb.Write(512, make([]byte, 512))
+	require.NoError(t, err)
+	time.Sleep(20 * time.Millisecond)
+	ff.Lock()
+	require.Equal(t, 2, ff.writes)
+	ff.Unlock()
+}
+
+func TestWriteBehindShortWrite(t *testing.T) {
+	ff := &fakeFile{limit: 300}
+	wb := newWriteBehind(1, time.Hour, ff.write)
+	data := make([]byte, 512)
+	for i := range data {
+		data[i] = byte(i)
+	}
+	_, err := wb.Write(0, data)
+	require.NoError(t, err)
+
+	// the unwritten tail stays buffered
+	require.Equal(t, io.ErrShortWrite, wb.Flush())
+	require.Equal(t, data[:300], ff.data)
+	ff.limit = 0
+	require.NoError(t, wb.Flush())
+	require.Equal(t, data, ff.data)
+	require.Equal(t, 2, ff.writes)
+}
+
+func TestSharedWriteBehind(t *testing.T) {
+	c := &client{writeBehindDelay: time.Hour, writeBehinds: make(map[uint64]*writeBehind)}
+	c.initMetaCache()
+	defer c.releaseMetaCache()
+	ff := &fakeFile{}
+	record := make([]byte, 512)
+
+	// the writers of a file share its buffer
+	a1, a2, b := &file{fd: 1, ino: 10}, &file{fd: 2, ino: 10}, &file{fd: 3, ino: 10}
+	c.getWriteBehind(a1, ff.write)
+	c.getWriteBehind(a2, ff.write)
+	require.True(t, a1.wb == a2.wb)
+	_, err := a1.wb.Write(0, record)
+	require.NoError(t, err)
+	_, err = a2.wb.Write(len(record), record)
+	require.NoError(t, err)
+	require.Equal(t, 0, ff.writes)
+
+	// a read through another fd writes it out
+	require.NoError(t, c.flushWriteBehind(b))
+	require.Equal(t, 1, ff.writes)
+	require.Len(t, ff.data, 2*len(record))
+
+	// and so does a stat of the file, which drops its cached attributes
+	c.ic.Put(&proto.InodeInfo{Inode: 10, Size: 2 * uint64(len(record))})
+	_, err = a1.wb.Write(2*len(record), record)
+	require.NoError(t, err)
+	c.writeOut(10)
+	require.Nil(t, c.ic.Get(10))
+	require.Len(t, ff.data, 3*len(record))
+
+	// the errors are returned to the writers only
+	ff.err = syscall.EIO
+	_, err = a2.wb.Write(3*len(record), record)
+	require.NoError(t, err)
+	require.NoError(t, c.flushWriteBehind(b))
+	ff.err = nil
+	require.Equal(t, syscall.EIO, a1.wb.Flush())
+	require.NoError(t, c.flushWriteBehind(a2))
+	require.Len(t, ff.data, 4*len(record))
+
+	c.putWriteBehind(a1)
+	require.Nil(t, a1.wb)
+	require.Len(t, c.writeBehinds, 1)
+	c.putWriteBehind(a2)
+	require.Empty(t, c.writeBehinds)
+}
+
+// loopbackWrite sends every write to a loopback connection, as a stand-in
+// for the per-packet cost of ExtentClient.Write.
+func loopbackWrite(b *testing.B) writeFunc {
+	ln, err := net.Listen("tcp", "127.0.0.1:0")
+	require.NoError(b, err)
+	go func() {
+		defer ln.Close()
+		conn, err := ln.Accept()
+		if err != nil {
+			return
+		}
+		io.Copy(io.Discard, conn)
+	}()
+	conn, err := net.Dial("tcp", ln.Addr().String())
+	require.NoError(b, err)
+	b.Cleanup(func() { conn.Close() })
+	return func(offset int, data []byte) (int, error) {
+		return conn.Write(data)
+	}
+}
+
+func BenchmarkSmallWriteThrough(b *testing.B) {
+	write := loopbackWrite(b)
+	record := make([]byte, 512)
+	b.SetBytes(int64(len(record)))
+	b.ResetTimer()
+	for i := 0; i < b.N; i++ {
+		if _, err := write(i*len(record), record); err != nil {
+			b.Fatal(err)
+		}
+	}
+}
+
+func BenchmarkSmallWriteBehind(b *testing.B) {
+	wb := newWriteBehind(1, time.Second, loopbackWrite(b))
+	record := make([]byte, 512)
+	b.SetBytes(int64(len(record)))
+	b.ResetTimer()
+	for i := 0; i < b.N; i++ {
+		if _, err := wb.Write(i*len(record), record); err != nil {
+			b.Fatal(err)
+		}
+	}
+	if err := wb.Flush(); err != nil {
+		b.Fatal(err)
+	}
+}
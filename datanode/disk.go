@@ -28,6 +28,7 @@ import (
 	"syscall"
 	"time"
 
+	"github.com/cubefs/cubefs/datanode/storage"
 	"github.com/cubefs/cubefs/depends/tiglabs/raft"
 	"github.com/cubefs/cubefs/proto"
 	"github.com/cubefs/cubefs/util/auditlog"
@@ -88,6 +89,7 @@ type Disk struct {
 	limitFactor map[uint32]*rate.Limiter
 	limitRead   *ioLimiter
 	limitWrite  *ioLimiter
+	ioEngine    storage.IOEngine // engine of the extent reads, writes and syncs, set by LoadDisk
 
 	// diskPartition info
 	diskPartition               *disk.PartitionStat
@@ -405,6 +407,18 @@ func (d *Disk) startScheduleToUpdateSpaceInfo() {
 	}()
 }
 
+// closeIOEngine closes the io engine of the disk, once no extent store uses
+// it anymore.
+func (d *Disk) closeIOEngine() {
+	if d.ioEngine == nil {
+		return
+	}
+	if err := d.ioEngine.Close(); err != nil {
+		log.LogErrorf("action[closeIOEngine] disk(%v) close io engine err(%v)", d.Path, err)
+	}
+	d.ioEngine = nil
+}
+
 func (d *Disk) doBackendTask() {
 	for {
 		partitions := make([]*DataPartition, 0)
@@ -18,6 +18,7 @@ import (
 	"fmt"
 	"time"
 
+	"github.com/cubefs/cubefs/datanode/storage"
 	"github.com/cubefs/cubefs/util/exporter"
 	"github.com/cubefs/cubefs/util/log"
 )
@@ -32,24 +33,30 @@ const (
 	MetricDpCount              = "dataPartitionCount"
 	MetricTotalDpSize          = "totalDpSize"
 	MetricCapacity             = "capacity"
+	MetricExtentCacheHitRate   = "extentCacheHitRate"
+	MetricExtentCacheEvictions = "extentCacheEvictions"
 )
 
 type DataNodeMetrics struct {
-	dataNode                 *DataNode
-	stopC                    chan struct{}
-	MetricIOBytes            *exporter.Counter
-	MetricLackDpCount        *exporter.GaugeVec
-	MetricCapacityToCreateDp *exporter.GaugeVec
-	MetricConnectionCnt      *exporter.Gauge
-	MetricDpCount            *exporter.Gauge
-	MetricTotalDpSize        *exporter.Gauge
-	MetricCapacity           *exporter.GaugeVec
+	dataNode                   *DataNode
+	stopC                      chan struct{}
+	MetricIOBytes              *exporter.Counter
+	MetricLackDpCount          *exporter.GaugeVec
+	MetricCapacityToCreateDp   *exporter.GaugeVec
+	MetricConnectionCnt        *exporter.Gauge
+	MetricDpCount              *exporter.Gauge
+	MetricTotalDpSize          *exporter.Gauge
+	MetricCapacity             *exporter.GaugeVec
+	MetricExtentCacheHitRate   *exporter.GaugeVec
+	MetricExtentCacheEvictions *exporter.GaugeVec // evictions per second
+	lastExtentCacheStats       map[string]storage.ExtentCacheStats
 }
 
 func (d *DataNode) registerMetrics() {
 	d.metrics = &DataNodeMetrics{
-		dataNode: d,
-		stopC:    make(chan struct{}),
+		dataNode:             d,
+		stopC:                make(chan struct{}),
+		lastExtentCacheStats: make(map[string]storage.ExtentCacheStats),
 	}
 	d.metrics.MetricIOBytes = exporter.NewCounter(MetricPartitionIOBytesName)
 	d.metrics.MetricLackDpCount = exporter.NewGaugeVec(MetricLackDpCount, "", []string{"type"})
@@ -58,6 +65,8 @@ func (d *DataNode) registerMetrics() {
 	d.metrics.MetricDpCount = exporter.NewGauge(MetricDpCount)
 	d.metrics.MetricTotalDpSize = exporter.NewGauge(MetricTotalDpSize)
 	d.metrics.MetricCapacity = exporter.NewGaugeVec(MetricCapacity, "", []string{"type"})
+	d.metrics.MetricExtentCacheHitRate = exporter.NewGaugeVec(MetricExtentCacheHitRate, "", []string{"disk"})
+	d.metrics.MetricExtentCacheEvictions = exporter.NewGaugeVec(MetricExtentCacheEvictions, "", []string{"disk"})
 }
 
 func (d *DataNode) startMetrics() {
@@ -104,6 +113,7 @@ func (dm *DataNodeMetrics) doStat() {
 	dm.setDpCountMetrics()
 	dm.setTotalDpSizeMetrics()
 	dm.setCapacityMetrics()
+	dm.setExtentCacheMetrics()
 }
 
 func (dm *DataNodeMetrics) setLackDpCountMetrics() {
@@ -143,3 +153,39 @@ func (dm *DataNodeMetrics) setCapacityMetrics() {
 	dm.MetricCapacity.SetWithLabelValues(float64(used), "used")
 	dm.MetricCapacity.SetWithLabelValues(float64(available), "available")
 }
+
+// setExtentCacheMetrics sets the hit rate and the eviction rate of the extent
+// caches of the partitions of each disk over the last period.
+func (dm *DataNodeMetrics) setExtentCacheMetrics() {
+	for _, d := range dm.dataNode.space.GetDisks() {
+		var cur storage.ExtentCacheStats
+		for _, partitionID := range d.DataPartitionList() {
+			partition := d.GetDataPartition(partitionID)
+			if partition == nil || partition.ExtentStore() == nil {
+				continue
+			}
+			stats := partition.ExtentStore().GetExtentCacheStats()
+			cur.Hits += stats.Hits
+			cur.Misses += stats.Misses
+			cur.Evictions += stats.Evictions
+		}
+		last := dm.lastExtentCacheStats[d.Path]
+		dm.lastExtentCacheStats[d.Path] = cur
+
+		// the counters of the partitions deleted meanwhile are gone
+		hits := counterDelta(cur.Hits, last.Hits)
+		misses := counterDelta(cur.Misses, last.Misses)
+		evictions := counterDelta(cur.Evictions, last.Evictions)
+		if hits+misses > 0 {
+			dm.MetricExtentCacheHitRate.SetWithLabelValues(float64(hits)/float64(hits+misses), d.Path)
+		}
+		dm.MetricExtentCacheEvictions.SetWithLabelValues(float64(evictions)/StatPeriod.Seconds(), d.Path)
+	}
+}
+
+func counterDelta(cur, last uint64) uint64 {
+	if cur < last {
+		return cur
+	}
+	return cur - last
+}
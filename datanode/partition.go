@@ -446,8 +446,8 @@ func newDataPartition(dpCfg *dataPartitionCfg, disk *Disk, isCreate bool) (dp *D
 		dpCfg.VolName, partitionID, partition.IsForbidWriteOpOfProtoVer0())
 
 	partition.replicasInit()
-	partition.extentStore, err = storage.NewExtentStore(partition.path, dpCfg.PartitionID, dpCfg.PartitionSize,
-		partition.partitionType, disk.dataNode.cacheCap, isCreate)
+	partition.extentStore, err = storage.NewExtentStoreWithIOEngine(partition.path, dpCfg.PartitionID, dpCfg.PartitionSize,
+		partition.partitionType, disk.dataNode.cacheCap, isCreate, disk.ioEngine)
 	if err != nil {
 		log.LogWarnf("action[newDataPartition] dp %v NewExtentStore failed %v", partitionID, err.Error())
 		return
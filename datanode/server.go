@@ -137,6 +137,15 @@ const (
 
 	// storage device media type, for hybrid cloud, in string: SDD or HDD
 	ConfigMediaType = "mediaType"
+
+	// engine of the extent reads and writes of the disks, psync or io_uring,
+	// overridden by the IO_ENGINE of a disk configured as
+	// PATH:RESERVE_SIZE:IO_ENGINE
+	ConfigKeyIOEngine = "ioEngine" // string
+
+	// microseconds the sync writes of a disk wait for more sync writes to
+	// commit with, 0 commits them as soon as the previous commit is done
+	ConfigKeySyncCommitWindowUs = "syncCommitWindowUs" // int
 )
 
 const cpuSampleDuration = 1 * time.Second
@@ -524,6 +533,8 @@ func (s *DataNode) startSpaceManager(cfg *config.Config) (err error) {
 	}
 	diskEnableReadRepairExtentLimit := cfg.GetBoolWithDefault(ConfigEnableDiskReadExtentLimit, false)
 	log.LogInfof("startSpaceManager preReserveSpace %d", diskRdonlySpace)
+	defaultIOEngine := cfg.GetString(ConfigKeyIOEngine)
+	syncCommitWindow := time.Duration(cfg.GetInt64(ConfigKeySyncCommitWindowUs)) * time.Microsecond
 
 	paths := make([]string, 0)
 	diskPath := cfg.GetString(ConfigKeyDiskPath)
@@ -550,12 +561,16 @@ func (s *DataNode) startSpaceManager(cfg *config.Config) (err error) {
 	for _, d := range paths {
 		log.LogDebugf("action[startSpaceManager] load disk raw config(%v).", d)
 
-		// format "PATH:RESET_SIZE
+		// format "PATH:RESET_SIZE[:IO_ENGINE]
 		arr := strings.Split(d, ":")
-		if len(arr) != 2 {
-			return errors.New("invalid disk configuration. Example: PATH:RESERVE_SIZE")
+		if len(arr) != 2 && len(arr) != 3 {
+			return errors.New("invalid disk configuration. Example: PATH:RESERVE_SIZE[:IO_ENGINE]")
 		}
 		path := arr[0]
+		ioEngine := defaultIOEngine
+		if len(arr) == 3 {
+			ioEngine = arr[2]
+		}
 		fileInfo, err := os.Stat(path)
 		if err != nil {
 			log.LogErrorf("Stat disk path [%v] error: [%s]", path, err)
@@ -580,9 +595,10 @@ func (s *DataNode) startSpaceManager(cfg *config.Config) (err error) {
 		}
 
 		wg.Add(1)
-		go func(wg *sync.WaitGroup, path string, reservedSpace uint64) {
+		go func(wg *sync.WaitGroup, path string, reservedSpace uint64, ioEngine string) {
 			defer wg.Done()
-			err := s.space.LoadDisk(path, reservedSpace, diskRdonlySpace, DefaultDiskMaxErr, diskEnableReadRepairExtentLimit)
+			err := s.space.LoadDisk(path, reservedSpace, diskRdonlySpace, DefaultDiskMaxErr, diskEnableReadRepairExtentLimit,
+				ioEngine, syncCommitWindow)
 			if err != nil {
 				log.LogErrorf("[startSpaceManager] load disk %v failed: %v", path, err)
 				return
@@ -593,7 +609,7 @@ func (s *DataNode) startSpaceManager(cfg *config.Config) (err error) {
 				log.LogErrorf("[startSpaceManager] disk %v is already IO error", path)
 				return
 			}
-		}(&wg, path, reservedSpace)
+		}(&wg, path, reservedSpace, ioEngine)
 	}
 
 	wg.Wait()
@@ -26,6 +26,7 @@ import (
 
 	syslog "log"
 
+	"github.com/cubefs/cubefs/datanode/storage"
 	"github.com/cubefs/cubefs/proto"
 	"github.com/cubefs/cubefs/raftstore"
 	"github.com/cubefs/cubefs/util"
@@ -166,6 +167,11 @@ func (manager *SpaceManager) Stop() {
 		}(d, dps)
 	}
 	wg.Wait()
+
+	// the extent stores are closed with their partitions
+	for _, d := range disks {
+		d.closeIOEngine()
+	}
 }
 
 func (manager *SpaceManager) GetAllDiskPartitions() []*disk.PartitionStat {
@@ -299,7 +305,7 @@ func (manager *SpaceManager) Stats() *Stats {
 }
 
 func (manager *SpaceManager) LoadDisk(path string, reservedSpace, diskRdonlySpace uint64, maxErrCnt int,
-	diskEnableReadRepairExtentLimit bool,
+	diskEnableReadRepairExtentLimit bool, ioEngine string, syncCommitWindow time.Duration,
 ) (err error) {
 	var (
 		disk    *Disk
@@ -321,9 +327,18 @@ func (manager *SpaceManager) LoadDisk(path string, reservedSpace, diskRdonlySpac
 			log.LogErrorf("NewDisk fail err:[%v]", err)
 			return
 		}
+		if disk.ioEngine, err = storage.NewIOEngine(ioEngine); err != nil {
+			log.LogErrorf("NewIOEngine fail err:[%v]", err)
+			return
+		}
+		log.LogInfof("action[LoadDisk] disk(%v) io engine(%v) sync commit window(%v).",
+			path, disk.ioEngine.Name(), syncCommitWindow)
+		disk.ioEngine = storage.WithGroupCommit(disk.ioEngine, syncCommitWindow)
 		err = disk.RestorePartition(visitor)
 		if err != nil {
 			log.LogErrorf("RestorePartition fail err:[%v]", err)
+			// no partition was loaded with the engine
+			disk.closeIOEngine()
 			return
 		}
 		manager.putDisk(disk)
@@ -19,9 +19,11 @@ import (
 	"math/rand"
 	"sort"
 	"strconv"
+	"sync/atomic"
 	"testing"
 	"time"
 
+	"github.com/cubefs/cubefs/datanode/storage"
 	"github.com/cubefs/cubefs/proto"
 	"github.com/cubefs/cubefs/util"
 	"github.com/stretchr/testify/require"
@@ -111,3 +113,40 @@ func TestSelectDiskForSmallDp(t *testing.T) {
 		t.Logf("disk(%v) left space(%v) GB", disk.Path, disk.Available/util.GB)
 	}
 }
+
+type closeCountEngine struct {
+	storage.IOEngine
+	closes int32
+}
+
+func (e *closeCountEngine) Close() error {
+	atomic.AddInt32(&e.closes, 1)
+	return e.IOEngine.Close()
+}
+
+func TestStopClosesIOEngine(t *testing.T) {
+	sm := &SpaceManager{
+		disks:              make(map[string]*Disk),
+		partitions:         make(map[uint64]*DataPartition),
+		stopC:              make(chan bool),
+		samplerDone:        make(chan struct{}),
+		currentStopDpCount: 1,
+	}
+	prepareDisksForSelectDiskTest(t, sm, 2)
+	var engines []*closeCountEngine
+	for _, disk := range sm.disks {
+		engine, err := storage.NewIOEngine(storage.IOEnginePsync)
+		require.NoError(t, err)
+		e := &closeCountEngine{IOEngine: engine}
+		disk.ioEngine = e
+		engines = append(engines, e)
+	}
+
+	sm.Stop()
+	for _, disk := range sm.disks {
+		require.Nil(t, disk.ioEngine)
+	}
+	for _, e := range engines {
+		require.EqualValues(t, 1, atomic.LoadInt32(&e.closes))
+	}
+}
@@ -220,6 +220,12 @@ type Extent struct {
 	header          []byte
 	snapshotDataOff uint64
 	dirty           atomicutil.Bool
+	engine          IOEngine // nil for psync
+	// running crc of the appends to the tail block, so that the crc of a
+	// block filled by unaligned appends is known without reading it back
+	tailCrc      uint32
+	tailBlockNo  int64
+	tailCrcBytes int64 // bytes of the tail block covered by tailCrc, 0 if none
 	sync.Mutex
 }
 
@@ -233,6 +239,27 @@ func NewExtentInCore(name string, extentID uint64) *Extent {
 	return e
 }
 
+func (e *Extent) readAt(f *os.File, b []byte, off int64) (int, error) {
+	if e.engine == nil {
+		return f.ReadAt(b, off)
+	}
+	return e.engine.ReadAt(f, b, off)
+}
+
+func (e *Extent) sync() error {
+	if e.engine == nil {
+		return e.file.Sync()
+	}
+	return e.engine.Sync(e.file)
+}
+
+func (e *Extent) writeAt(b []byte, off int64) (int, error) {
+	if e.engine == nil {
+		return e.file.WriteAt(b, off)
+	}
+	return e.engine.WriteAt(e.file, b, off)
+}
+
 func (e *Extent) String() string {
 	return fmt.Sprintf("%v_%v_%v", e.filePath, e.dataSize, e.snapshotDataOff)
 }
@@ -436,14 +463,9 @@ func (e *Extent) WriteTiny(param *WriteParam) (err error) {
 		return ParameterMismatchError
 	}
 
-	if _, err = e.file.WriteAt(param.Data[:param.Size], int64(param.Offset)); err != nil {
+	if _, err = e.writeAt(param.Data[:param.Size], int64(param.Offset)); err != nil {
 		return
 	}
-	if param.IsSync {
-		if err = e.file.Sync(); err != nil {
-			return
-		}
-	}
 
 	if !IsAppendWrite(param.WriteType) {
 		return
@@ -456,18 +478,30 @@ func (e *Extent) WriteTiny(param *WriteParam) (err error) {
 	return
 }
 
-// Write writes data to an extent.
+// Write writes data to an extent. A sync write returns once the data is
+// durable. The sync is done after the extent lock is released, so that it
+// does not hold up the other writes of the extent, and through the engine,
+// which may commit it together with the syncs of other writes of the disk.
 func (e *Extent) Write(param *WriteParam, crcFunc UpdateCrcFunc) (status uint8, err error) {
-	defer func() {
-		e.dirty.Store(!param.IsSync)
-	}()
+	if status, err = e.write(param, crcFunc); err != nil || !param.IsSync {
+		return
+	}
+	// cleared before the sync, which covers the writes done so far, and set
+	// back if it fails so that Flush syncs them
+	e.dirty.Store(false)
+	if err = e.sync(); err != nil {
+		e.dirty.Store(true)
+		log.LogErrorf("action[Extent.Write] path %v sync write param(%v) err %v", e.filePath, param, err)
+	}
+	return
+}
+
+func (e *Extent) write(param *WriteParam, crcFunc UpdateCrcFunc) (status uint8, err error) {
+	defer e.dirty.Store(true)
 
 	if logger.IsEnableDebug() {
 		log.LogDebugf("action[Extent.Write] path %v write param(%v)", e.filePath, param)
 	}
-	defer func() {
-		e.dirty.Store(!param.IsSync)
-	}()
 
 	status = proto.OpOk
 	if IsTinyExtent(e.extentID) {
@@ -508,7 +542,7 @@ func (e *Extent) Write(param *WriteParam, crcFunc UpdateCrcFunc) (status uint8,
 			return
 		}
 	} else {
-		if _, err = e.file.WriteAt(param.Data[:param.Size], int64(param.Offset)); err != nil {
+		if _, err = e.writeAt(param.Data[:param.Size], int64(param.Offset)); err != nil {
 			log.LogErrorf("action[Extent.Write] path %v  write param(%v) err %v", e.filePath, param, err)
 			return
 		}
@@ -530,13 +564,6 @@ func (e *Extent) Write(param *WriteParam, crcFunc UpdateCrcFunc) (status uint8,
 		}
 	}()
 
-	if param.IsSync {
-		if err = e.file.Sync(); err != nil {
-			log.LogDebugf("action[Extent.Write] write param(%v) err %v", param, err)
-			return
-		}
-	}
-
 	// NOTE: compute crc
 	beginOffset := param.Offset
 	endOffset := param.Offset + param.Size
@@ -553,19 +580,48 @@ func (e *Extent) Write(param *WriteParam, crcFunc UpdateCrcFunc) (status uint8,
 
 		// NOTE: aliagn, compute crc
 		if offsetInBlock == 0 && sizeInBlock == util.BlockSize {
+			if blockNo == e.tailBlockNo {
+				e.tailCrcBytes = 0
+			}
 			err = crcFunc(e, int(blockNo), param.Crc)
 			log.LogDebugf("action[Extent.Write] write param(%v) err %v crcOffset %v", param, err, beginOffset)
 			beginOffset += sizeInBlock
 			continue
 		}
-		// NOTE: not aliagn
-		err = crcFunc(e, int(blockNo), 0)
+		// NOTE: not aliagn, the crc is known if appends filled the block
+		err = crcFunc(e, int(blockNo), e.updateTailCrc(param, blockNo, offsetInBlock, beginOffset-param.Offset, sizeInBlock))
 		log.LogDebugf("action[Extent.Write]  write param(%v) err %v crcOffset %v", param, err, beginOffset)
 		beginOffset += sizeInBlock
 	}
 	return
 }
 
+// updateTailCrc extends the running crc of the tail block with the size
+// bytes at dataOff of the data of an append, which go to offsetInBlock of
+// block blockNo. It returns the crc of the block once appends have filled
+// it, and 0 otherwise.
+func (e *Extent) updateTailCrc(param *WriteParam, blockNo, offsetInBlock, dataOff, size int64) uint32 {
+	if !IsAppendWrite(param.WriteType) || param.IsHole {
+		if blockNo == e.tailBlockNo {
+			e.tailCrcBytes = 0
+		}
+		return 0
+	}
+	if offsetInBlock == 0 {
+		e.tailBlockNo, e.tailCrc = blockNo, 0
+	} else if blockNo != e.tailBlockNo || offsetInBlock != e.tailCrcBytes {
+		e.tailCrcBytes = 0
+		return 0
+	}
+	e.tailCrc = crc32.Update(e.tailCrc, crc32.IEEETable, param.Data[dataOff:dataOff+size])
+	e.tailCrcBytes = offsetInBlock + size
+	if e.tailCrcBytes < util.BlockSize {
+		return 0
+	}
+	e.tailCrcBytes = 0
+	return e.tailCrc
+}
+
 // Read reads data from an extent.
 func (e *Extent) Read(data []byte, offset, size int64, isRepairRead, directRead bool) (crc uint32, err error) {
 	if IsTinyExtent(e.extentID) {
@@ -580,7 +636,7 @@ func (e *Extent) Read(data []byte, offset, size int64, isRepairRead, directRead
 	var rSize int
 	if size < util.BlockSize && directRead {
 		err = e.ReadAligned(data, offset, size)
-	} else if rSize, err = e.file.ReadAt(data[:size], offset); err != nil {
+	} else if rSize, err = e.readAt(e.file, data[:size], offset); err != nil {
 		log.LogErrorf("action[Extent.Read]extent %v offset %v size %v err %v realsize %v", e.extentID, offset, size, err, rSize)
 		return
 	}
@@ -605,7 +661,7 @@ func (e *Extent) ReadAligned(data []byte, offset, size int64) error {
 
 	newData := alignedBlock(int(newSize), block)
 
-	n, err := e.readFile.ReadAt(newData, start)
+	n, err := e.readAt(e.readFile, newData, start)
 	if err != nil && err != io.EOF {
 		return err
 	}
@@ -623,7 +679,7 @@ func (e *Extent) ReadAligned(data []byte, offset, size int64) error {
 
 // ReadTiny read data from a tiny extent.
 func (e *Extent) ReadTiny(data []byte, offset, size int64, isRepairRead bool) (crc uint32, err error) {
-	_, err = e.file.ReadAt(data[:size], offset)
+	_, err = e.readAt(e.file, data[:size], offset)
 	if isRepairRead && err == io.EOF {
 		err = nil
 	}
@@ -665,7 +721,9 @@ func (e *Extent) Flush() (err error) {
 	if e.HasClosed() || !e.dirty.CompareAndSwap(true, false) {
 		return
 	}
-	err = e.file.Sync()
+	if err = e.file.Sync(); err != nil {
+		e.dirty.Store(true)
+	}
 	return
 }
 
@@ -684,13 +742,16 @@ func (e *Extent) autoComputeExtentCrc(extSize int64, crcFunc UpdateCrcFunc) (crc
 	}
 	log.LogDebugf("autoComputeExtentCrc. path %v extent %v extent size %v,blockCnt %v", e.filePath, e.extentID, extSize, blockCnt)
 	crcData := make([]byte, blockCnt*util.PerBlockCrcSize)
+	var bdata []byte
 	for blockNo := 0; blockNo < blockCnt; blockNo++ {
 		blockCrc := binary.BigEndian.Uint32(e.header[blockNo*util.PerBlockCrcSize : (blockNo+1)*util.PerBlockCrcSize])
 		if blockCrc != 0 {
 			binary.BigEndian.PutUint32(crcData[blockNo*util.PerBlockCrcSize:(blockNo+1)*util.PerBlockCrcSize], blockCrc)
 			continue
 		}
-		bdata := make([]byte, util.BlockSize)
+		if bdata == nil {
+			bdata = make([]byte, util.BlockSize)
+		}
 		offset := int64(blockNo * util.BlockSize)
 		readN, err := e.file.ReadAt(bdata[:util.BlockSize], offset)
 		if readN == 0 && err != nil {
@@ -732,6 +793,10 @@ func (e *Extent) punchDelete(offset, size int64) (hasDelete bool, err error) {
 		return true, nil
 	}
 	log.LogDebugf("punchDelete offset %v size %v", offset, size)
+	e.Lock()
+	defer e.Unlock()
+	// the running crc of the tail block no longer matches its data
+	e.tailCrcBytes = 0
 	err = fallocate(int(e.file.Fd()), util.FallocFLPunchHole|util.FallocFLKeepSize, offset, size)
 	return
 }
@@ -796,10 +861,11 @@ func (e *Extent) TinyExtentRecover(data []byte, offset, size int64, crc uint32,
 	if !IsTinyExtent(e.extentID) {
 		return ParameterMismatchError
 	}
+	e.tailCrcBytes = 0
 	if isEmptyPacket {
 		err = e.repairPunchHole(offset, size)
 	} else {
-		_, err = e.file.WriteAt(data[:size], int64(offset))
+		_, err = e.writeAt(data[:size], int64(offset))
 	}
 	if err != nil {
 		return
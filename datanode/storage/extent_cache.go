@@ -17,6 +17,7 @@ package storage
 import (
 	"container/list"
 	"sync"
+	"sync/atomic"
 	"time"
 
 	"github.com/cubefs/cubefs/util/log"
@@ -24,23 +25,61 @@ import (
 
 const (
 	minCacheCap = 100
+
+	extentCacheShards = 64
+	// an eviction frees capacity/extentCacheEvictBatch more extents than
+	// needed, so that misses do not each run the clock hand
+	extentCacheEvictBatch = 32
+	// batches of evicted extents waiting for the closer
+	extentCacheCloseQueue = 64
 )
 
-// ExtentMapItem stores the extent entity pointer and the element
-// pointer of the extent entity in a cache list.
-type ExtentMapItem struct {
+type extentCacheEntry struct {
 	e       *Extent
-	element *list.Element
+	ref     int32         // set by hits, cleared by the clock hand
+	element *list.Element // in ExtentCache.clock, guarded by clockLock
+}
+
+type extentCacheShard struct {
+	sync.RWMutex
+	entries map[uint64]*extentCacheEntry
+	hits    uint64
+	misses  uint64
+	_       [16]byte // keep the shards on separate cache lines
 }
 
-// ExtentCache is an implementation of the ExtentCache with LRU support.
+// ExtentCacheStats counts the lookups of normal extents in an ExtentCache
+// and the extents it evicted since it was created.
+type ExtentCacheStats struct {
+	Hits      uint64
+	Misses    uint64
+	Evictions uint64
+}
+
+// ExtentCache caches the open normal extents of a partition up to its
+// capacity, and all of its tiny extents.
+//
+// The normal extents are replaced with the CLOCK algorithm. A hit only read
+// locks the shard holding the extent and marks the extent as referenced, so
+// concurrent reads of different extents do not contend. Inserts and
+// evictions are serialized by clockLock. A new extent is inserted right
+// behind the hand, which sweeps the extents, clearing the referenced ones
+// and evicting the others, until a batch of extents is evicted. The evicted
+// extents are handed to the closer goroutine of the cache, so that the
+// close syscalls are not paid by the miss which triggered the eviction.
 type ExtentCache struct {
-	extentMap   map[uint64]*ExtentMapItem
-	extentList  *list.List
+	shards      [extentCacheShards]extentCacheShard
+	clockLock   sync.Mutex
+	clock       *list.List
+	hand        *list.Element
+	evictions   uint64
 	tinyExtents map[uint64]*Extent
 	tinyLock    sync.RWMutex
-	lock        sync.RWMutex
 	capacity    int
+
+	closeLock  sync.RWMutex
+	closeC     chan []*Extent // nil once Clear stopped the closer
+	closerDone chan struct{}
 }
 
 // NewExtentCache creates and returns a new ExtentCache instance.
@@ -49,14 +88,58 @@ func NewExtentCache(capacity int) *ExtentCache {
 		capacity = minCacheCap
 	}
 
-	return &ExtentCache{
-		extentMap:   make(map[uint64]*ExtentMapItem),
-		extentList:  list.New(),
+	cache := &ExtentCache{
+		clock:       list.New(),
 		capacity:    capacity,
 		tinyExtents: make(map[uint64]*Extent),
+		closeC:      make(chan []*Extent, extentCacheCloseQueue),
+		closerDone:  make(chan struct{}),
+	}
+	for i := range cache.shards {
+		cache.shards[i].entries = make(map[uint64]*extentCacheEntry)
+	}
+	go cache.closer(cache.closeC)
+	return cache
+}
+
+func (cache *ExtentCache) closer(closeC chan []*Extent) {
+	defer close(cache.closerDone)
+	for victims := range closeC {
+		for _, victim := range victims {
+			victim.Close()
+		}
 	}
 }
 
+// close hands victims to the closer, or closes them if it's stopped.
+func (cache *ExtentCache) close(victims []*Extent) {
+	cache.closeLock.RLock()
+	defer cache.closeLock.RUnlock()
+	if cache.closeC != nil {
+		cache.closeC <- victims
+		return
+	}
+	for _, victim := range victims {
+		victim.Close()
+	}
+}
+
+// stopCloser waits for the closer to close the extents handed to it.
+func (cache *ExtentCache) stopCloser() {
+	cache.closeLock.Lock()
+	closeC := cache.closeC
+	cache.closeC = nil
+	cache.closeLock.Unlock()
+	if closeC != nil {
+		close(closeC)
+		<-cache.closerDone
+	}
+}
+
+func (cache *ExtentCache) shard(extentID uint64) *extentCacheShard {
+	return &cache.shards[extentID%extentCacheShards]
+}
+
 // Put puts an extent object into the cache.
 func (cache *ExtentCache) Put(e *Extent) {
 	if IsTinyExtent(e.extentID) {
@@ -65,14 +148,32 @@ func (cache *ExtentCache) Put(e *Extent) {
 		cache.tinyLock.Unlock()
 		return
 	}
-	cache.lock.Lock()
-	defer cache.lock.Unlock()
-	item := &ExtentMapItem{
-		e:       e,
-		element: cache.extentList.PushBack(e),
+	entry := &extentCacheEntry{e: e}
+	var victims []*Extent
+
+	cache.clockLock.Lock()
+	s := cache.shard(e.extentID)
+	s.Lock()
+	old, ok := s.entries[e.extentID]
+	s.entries[e.extentID] = entry
+	s.Unlock()
+	if ok {
+		cache.unlink(old)
+		if old.e != e {
+			victims = append(victims, old.e)
+		}
+	}
+	if cache.hand == nil {
+		entry.element = cache.clock.PushBack(entry)
+	} else {
+		entry.element = cache.clock.InsertBefore(entry, cache.hand)
+	}
+	victims = cache.evict(victims)
+	cache.clockLock.Unlock()
+
+	if len(victims) > 0 {
+		cache.close(victims)
 	}
-	cache.extentMap[e.extentID] = item
-	cache.evict()
 }
 
 // Get gets the extent from the cache.
@@ -83,16 +184,19 @@ func (cache *ExtentCache) Get(extentID uint64) (e *Extent, ok bool) {
 		cache.tinyLock.RUnlock()
 		return
 	}
-	cache.lock.Lock()
-	defer cache.lock.Unlock()
-	var item *ExtentMapItem
-	if item, ok = cache.extentMap[extentID]; ok {
-		if !IsTinyExtent(extentID) {
-			cache.extentList.MoveToBack(item.element)
-		}
-		e = item.e
+	s := cache.shard(extentID)
+	s.RLock()
+	entry, ok := s.entries[extentID]
+	s.RUnlock()
+	if !ok {
+		atomic.AddUint64(&s.misses, 1)
+		return
 	}
-	return
+	atomic.AddUint64(&s.hits, 1)
+	if atomic.LoadInt32(&entry.ref) == 0 {
+		atomic.StoreInt32(&entry.ref, 1)
+	}
+	return entry.e, true
 }
 
 // Del deletes the extent stored in the cache.
@@ -100,66 +204,102 @@ func (cache *ExtentCache) Del(extentID uint64) {
 	if IsTinyExtent(extentID) {
 		return
 	}
-	cache.lock.Lock()
-	defer cache.lock.Unlock()
-	var (
-		item *ExtentMapItem
-		ok   bool
-	)
-	if item, ok = cache.extentMap[extentID]; ok {
-		delete(cache.extentMap, extentID)
-		cache.extentList.Remove(item.element)
+	cache.clockLock.Lock()
+	s := cache.shard(extentID)
+	s.Lock()
+	entry, ok := s.entries[extentID]
+	delete(s.entries, extentID)
+	s.Unlock()
+	if ok {
+		cache.unlink(entry)
+	}
+	cache.clockLock.Unlock()
 
-		item.e.Close()
+	if ok {
+		entry.e.Close()
 	}
 }
 
-// Clear closes all the extents stored in the cache.
+// Clear closes all the extents stored in the cache, and the ones evicted
+// before. The extents evicted afterwards are closed by Put.
 func (cache *ExtentCache) Clear() {
+	cache.stopCloser()
+
 	cache.tinyLock.RLock()
 	for _, extent := range cache.tinyExtents {
 		extent.Close()
 	}
 	cache.tinyLock.RUnlock()
 
-	cache.lock.Lock()
-	defer cache.lock.Unlock()
-	for e := cache.extentList.Front(); e != nil; {
-		curr := e
-		e = e.Next()
-		ec := curr.Value.(*Extent)
-		delete(cache.extentMap, ec.extentID)
+	cache.clockLock.Lock()
+	for i := range cache.shards {
+		s := &cache.shards[i]
+		s.Lock()
+		s.entries = make(map[uint64]*extentCacheEntry)
+		s.Unlock()
+	}
+	clock := cache.clock
+	cache.clock = list.New()
+	cache.hand = nil
+	cache.clockLock.Unlock()
 
-		ec.Close()
-		cache.extentList.Remove(curr)
+	for element := clock.Front(); element != nil; element = element.Next() {
+		element.Value.(*extentCacheEntry).e.Close()
 	}
-	cache.extentList = list.New()
-	cache.extentMap = make(map[uint64]*ExtentMapItem)
 }
 
 // Size returns number of extents stored in the cache.
 func (cache *ExtentCache) Size() int {
-	cache.lock.RLock()
-	defer cache.lock.RUnlock()
-	return cache.extentList.Len()
+	cache.clockLock.Lock()
+	defer cache.clockLock.Unlock()
+	return cache.clock.Len()
 }
 
-func (cache *ExtentCache) evict() {
-	if cache.capacity <= 0 {
-		return
+// Stats returns the lookup and eviction counters of the cache.
+func (cache *ExtentCache) Stats() (stats ExtentCacheStats) {
+	for i := range cache.shards {
+		stats.Hits += atomic.LoadUint64(&cache.shards[i].hits)
+		stats.Misses += atomic.LoadUint64(&cache.shards[i].misses)
+	}
+	stats.Evictions = atomic.LoadUint64(&cache.evictions)
+	return
+}
+
+// evict runs the clock hand if the cache is over capacity, and appends the
+// evicted extents to victims. It must be called with clockLock held.
+func (cache *ExtentCache) evict(victims []*Extent) []*Extent {
+	if cache.clock.Len() <= cache.capacity {
+		return victims
 	}
-	needRemove := cache.extentList.Len() - cache.capacity
-	for i := 0; i < needRemove; i++ {
-		if e := cache.extentList.Front(); e != nil {
-			front := e.Value.(*Extent)
-			if IsTinyExtent(front.extentID) {
-				continue
-			}
-			delete(cache.extentMap, front.extentID)
-			cache.extentList.Remove(e)
-			front.Close()
+	target := cache.capacity - cache.capacity/extentCacheEvictBatch
+	for cache.clock.Len() > target {
+		if cache.hand == nil {
+			cache.hand = cache.clock.Front()
 		}
+		entry := cache.hand.Value.(*extentCacheEntry)
+		if atomic.LoadInt32(&entry.ref) != 0 {
+			atomic.StoreInt32(&entry.ref, 0)
+			cache.hand = cache.hand.Next()
+			continue
+		}
+		s := cache.shard(entry.e.extentID)
+		s.Lock()
+		delete(s.entries, entry.e.extentID)
+		s.Unlock()
+		cache.unlink(entry)
+		victims = append(victims, entry.e)
+		atomic.AddUint64(&cache.evictions, 1)
+	}
+	return victims
+}
+
+// unlink removes entry from the clock, it must be called with clockLock
+// held.
+func (cache *ExtentCache) unlink(entry *extentCacheEntry) {
+	if cache.hand == entry.element {
+		cache.hand = cache.hand.Next()
 	}
+	cache.clock.Remove(entry.element)
 }
 
 func (cache *ExtentCache) CopyAndFlush(motifyInterval time.Duration) {
@@ -174,13 +314,14 @@ func (cache *ExtentCache) CopyAndFlush(motifyInterval time.Duration) {
 		}
 	}()
 
-	func() {
-		cache.lock.RLock()
-		defer cache.lock.RUnlock()
-		for _, extent := range cache.extentMap {
-			normalExtents = append(normalExtents, extent.e)
+	for i := range cache.shards {
+		s := &cache.shards[i]
+		s.RLock()
+		for _, entry := range s.entries {
+			normalExtents = append(normalExtents, entry.e)
 		}
-	}()
+		s.RUnlock()
+	}
 
 	for _, extent := range tinyExtents {
 		lastMotify := time.Unix(extent.ModifyTime(), 0)
@@ -213,9 +354,12 @@ func (cache *ExtentCache) Flush() {
 	}
 	cache.tinyLock.RUnlock()
 
-	cache.lock.RLock()
-	defer cache.lock.RUnlock()
-	for _, item := range cache.extentMap {
-		item.e.Flush()
+	for i := range cache.shards {
+		s := &cache.shards[i]
+		s.RLock()
+		for _, entry := range s.entries {
+			entry.e.Flush()
+		}
+		s.RUnlock()
 	}
 }
@@ -0,0 +1,102 @@
+// Copyright 2024 The CubeFS Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+
+package storage_test
+
+import (
+	"fmt"
+	"os"
+	"testing"
+	"time"
+
+	"github.com/cubefs/cubefs/datanode/storage"
+	"github.com/stretchr/testify/require"
+)
+
+func newTestCacheExtent(t *testing.T, dir string, id uint64) *storage.Extent {
+	e := storage.NewExtentInCore(fmt.Sprintf("%s/%d", dir, id), id)
+	require.NoError(t, e.InitToFS())
+	return e
+}
+
+func TestExtentCacheClock(t *testing.T) {
+	dir, err := os.MkdirTemp(os.TempDir(), "cfs_storage_extentcache_")
+	require.NoError(t, err)
+	defer os.RemoveAll(dir)
+
+	const capacity = 8
+	cache := storage.NewExtentCache(capacity)
+	const hotID = 1000
+	hot := newTestCacheExtent(t, dir, hotID)
+	cache.Put(hot)
+
+	extents := map[uint64]*storage.Extent{hotID: hot}
+	for id := uint64(hotID + 1); id < hotID+100; id++ {
+		_, ok := cache.Get(hotID)
+		require.True(t, ok)
+		e := newTestCacheExtent(t, dir, id)
+		cache.Put(e)
+		extents[id] = e
+		require.LessOrEqual(t, cache.Size(), capacity)
+	}
+
+	// the extent used between every insert is never evicted
+	e, ok := cache.Get(hotID)
+	require.True(t, ok)
+	require.Equal(t, hot, e)
+	require.False(t, hot.HasClosed())
+
+	// the evicted extents are closed in the background
+	cached := 0
+	for id, e := range extents {
+		if _, ok := cache.Get(id); ok {
+			require.False(t, e.HasClosed())
+			cached++
+		} else {
+			require.Eventually(t, e.HasClosed, time.Second, time.Millisecond)
+		}
+	}
+	require.Equal(t, cache.Size(), cached)
+
+	stats := cache.Stats()
+	require.EqualValues(t, len(extents)-cache.Size(), stats.Evictions)
+	require.EqualValues(t, len(extents)-cached, stats.Misses)
+	require.EqualValues(t, 99+1+cached, stats.Hits)
+
+	cache.Del(hotID)
+	require.True(t, hot.HasClosed())
+	_, ok = cache.Get(hotID)
+	require.False(t, ok)
+
+	cache.Clear()
+	require.Equal(t, 0, cache.Size())
+	for _, e := range extents {
+		require.True(t, e.HasClosed())
+	}
+
+	// the closer is stopped, the victims are closed by Put
+	for id := uint64(hotID + 100); id < hotID+110; id++ {
+		e := newTestCacheExtent(t, dir, id)
+		cache.Put(e)
+		extents[id] = e
+	}
+	closed := 0
+	for _, e := range extents {
+		if e.HasClosed() {
+			closed++
+		}
+	}
+	require.Equal(t, len(extents)-cache.Size(), closed)
+	cache.Clear()
+}
@@ -0,0 +1,97 @@
+// Copyright 2024 The CubeFS Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+
+package storage
+
+import (
+	"sync"
+	"sync/atomic"
+)
+
+const extentInfoShards = 64
+
+type extentInfoShard struct {
+	sync.RWMutex
+	m map[uint64]*ExtentInfo
+	_ [32]byte // keep the shards on separate cache lines
+}
+
+// extentInfoMap maps extent ids to their ExtentInfo. It is looked up by every
+// read and write of the partition, so the entries are spread over shards by
+// extent id and concurrent operations on different extents do not share a
+// lock. The count is kept apart so that it can be read without any lock.
+type extentInfoMap struct {
+	shards [extentInfoShards]extentInfoShard
+	count  int64
+}
+
+func newExtentInfoMap() *extentInfoMap {
+	m := &extentInfoMap{}
+	for i := range m.shards {
+		m.shards[i].m = make(map[uint64]*ExtentInfo)
+	}
+	return m
+}
+
+func (m *extentInfoMap) shard(extentID uint64) *extentInfoShard {
+	return &m.shards[extentID%extentInfoShards]
+}
+
+func (m *extentInfoMap) Load(extentID uint64) (ei *ExtentInfo, ok bool) {
+	s := m.shard(extentID)
+	s.RLock()
+	ei, ok = s.m[extentID]
+	s.RUnlock()
+	return
+}
+
+func (m *extentInfoMap) Store(extentID uint64, ei *ExtentInfo) {
+	s := m.shard(extentID)
+	s.Lock()
+	if _, ok := s.m[extentID]; !ok {
+		atomic.AddInt64(&m.count, 1)
+	}
+	s.m[extentID] = ei
+	s.Unlock()
+}
+
+func (m *extentInfoMap) Delete(extentID uint64) {
+	s := m.shard(extentID)
+	s.Lock()
+	if _, ok := s.m[extentID]; ok {
+		delete(s.m, extentID)
+		atomic.AddInt64(&m.count, -1)
+	}
+	s.Unlock()
+}
+
+func (m *extentInfoMap) Len() int {
+	return int(atomic.LoadInt64(&m.count))
+}
+
+// Range calls f for every extent until f returns false. Each shard is read
+// locked while its extents are visited, so f must not modify the map.
+func (m *extentInfoMap) Range(f func(extentID uint64, ei *ExtentInfo) bool) {
+	for i := range m.shards {
+		s := &m.shards[i]
+		s.RLock()
+		for id, ei := range s.m {
+			if !f(id, ei) {
+				s.RUnlock()
+				return
+			}
+		}
+		s.RUnlock()
+	}
+}
@@ -0,0 +1,120 @@
+// Copyright 2024 The CubeFS Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+
+package storage
+
+import (
+	"fmt"
+	"sync"
+	"sync/atomic"
+	"testing"
+
+	"github.com/stretchr/testify/require"
+)
+
+func TestExtentInfoMap(t *testing.T) {
+	m := newExtentInfoMap()
+	for id := uint64(1); id <= 1000; id++ {
+		m.Store(id, &ExtentInfo{FileID: id})
+	}
+	m.Store(1, &ExtentInfo{FileID: 1})
+	require.Equal(t, 1000, m.Len())
+
+	ei, ok := m.Load(500)
+	require.True(t, ok)
+	require.EqualValues(t, 500, ei.FileID)
+	_, ok = m.Load(1001)
+	require.False(t, ok)
+
+	m.Delete(500)
+	m.Delete(500)
+	require.Equal(t, 999, m.Len())
+	_, ok = m.Load(500)
+	require.False(t, ok)
+
+	seen := 0
+	m.Range(func(id uint64, ei *ExtentInfo) bool {
+		require.Equal(t, id, ei.FileID)
+		seen++
+		return true
+	})
+	require.Equal(t, 999, seen)
+
+	seen = 0
+	m.Range(func(uint64, *ExtentInfo) bool {
+		seen++
+		return seen < 10
+	})
+	require.Equal(t, 10, seen)
+}
+
+// mutexExtentInfoMap is the single exclusive lock map that extentInfoMap
+// replaced in ExtentStore.Write, kept for comparison.
+type mutexExtentInfoMap struct {
+	sync.Mutex
+	m map[uint64]*ExtentInfo
+}
+
+func (m *mutexExtentInfoMap) Load(id uint64) (ei *ExtentInfo, ok bool) {
+	m.Lock()
+	ei, ok = m.m[id]
+	m.Unlock()
+	return
+}
+
+const benchExtents = 10000
+
+func benchmarkExtentInfoLoad(b *testing.B, load func(id uint64) (*ExtentInfo, bool)) {
+	for _, goroutines := range []int{1, 4, 16, 64} {
+		b.Run(fmt.Sprintf("goroutines-%d", goroutines), func(b *testing.B) {
+			var next uint64
+			per := (b.N + goroutines - 1) / goroutines
+			var wg sync.WaitGroup
+			b.ResetTimer()
+			for g := 0; g < goroutines; g++ {
+				wg.Add(1)
+				go func() {
+					defer wg.Done()
+					id := atomic.AddUint64(&next, 7919)
+					for i := 0; i < per; i++ {
+						if _, ok := load(id%benchExtents + 1); !ok {
+							panic("extent not found")
+						}
+						id++
+					}
+				}()
+			}
+			wg.Wait()
+		})
+	}
+}
+
+// BenchmarkExtentInfoLoad reports the time per lookup with all the
+// goroutines looking up extents, ns/op dropping with the goroutine count
+// means the lookups scale.
+func BenchmarkExtentInfoLoad(b *testing.B) {
+	m := newExtentInfoMap()
+	for id := uint64(1); id <= benchExtents; id++ {
+		m.Store(id, &ExtentInfo{FileID: id})
+	}
+	benchmarkExtentInfoLoad(b, m.Load)
+}
+
+func BenchmarkExtentInfoLoadMutex(b *testing.B) {
+	m := &mutexExtentInfoMap{m: make(map[uint64]*ExtentInfo)}
+	for id := uint64(1); id <= benchExtents; id++ {
+		m.m[id] = &ExtentInfo{FileID: id}
+	}
+	benchmarkExtentInfoLoad(b, m.Load)
+}
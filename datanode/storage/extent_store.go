@@ -122,10 +122,10 @@ var (
 // In addition, the deletion of small files is implemented by the punch hole from the underlying file system.
 type ExtentStore struct {
 	dataPath               string
-	baseExtentID           uint64                 // TODO what is baseExtentID
-	extentInfoMap          map[uint64]*ExtentInfo // map that stores all the extent information
-	eiMutex                sync.RWMutex
-	cache                  *ExtentCache // extent cache
+	baseExtentID           uint64         // TODO what is baseExtentID
+	extentInfoMap          *extentInfoMap // map that stores all the extent information
+	cache                  *ExtentCache   // extent cache
+	ioEngine               IOEngine       // engine of the extents, nil for psync
 	mutex                  sync.Mutex
 	storeSize              int      // size of the extent store
 	metadataFp             *os.File // metadata file pointer?
@@ -158,12 +158,21 @@ func MkdirAll(name string) (err error) {
 }
 
 func NewExtentStore(dataDir string, partitionID uint64, storeSize, dpType, cap int, isCreate bool) (s *ExtentStore, err error) {
+	return NewExtentStoreWithIOEngine(dataDir, partitionID, storeSize, dpType, cap, isCreate, nil)
+}
+
+// NewExtentStoreWithIOEngine creates an extent store whose extents are read
+// and written through engine, psync if engine is nil.
+func NewExtentStoreWithIOEngine(dataDir string, partitionID uint64, storeSize, dpType, cap int, isCreate bool,
+	engine IOEngine,
+) (s *ExtentStore, err error) {
 	begin := time.Now()
 	defer func() {
 		log.LogInfof("[NewExtentStore] load dp(%v) new extent store using time(%v)", partitionID, time.Since(begin))
 	}()
 	s = new(ExtentStore)
 	s.dataPath = dataDir
+	s.ioEngine = engine
 	s.partitionType = dpType
 	s.partitionID = partitionID
 
@@ -233,7 +242,7 @@ func NewExtentStore(dataDir string, partitionID uint64, storeSize, dpType, cap i
 		log.LogInfof("[NewExtentStore] load dp(%v) write zero buffer", partitionID)
 	}
 
-	s.extentInfoMap = make(map[uint64]*ExtentInfo)
+	s.extentInfoMap = newExtentInfoMap()
 	s.extentLockMap = make(map[uint64]proto.GcFlag)
 	s.cache = NewExtentCache(cap)
 	if err = s.initBaseFileID(); err != nil {
@@ -369,6 +378,7 @@ func (s *ExtentStore) Create(extentID uint64) (err error) {
 	stat.RecordStat(s.partitionID, "Create", s.dataPath)
 
 	e = NewExtentInCore(name, extentID)
+	e.engine = s.ioEngine
 	e.header = make([]byte, util.BlockHeaderSize)
 	err = e.InitToFS()
 	if err != nil {
@@ -380,9 +390,7 @@ func (s *ExtentStore) Create(extentID uint64) (err error) {
 	extInfo.UpdateExtentInfo(e, 0)
 
 	atomic.StoreInt64(&extInfo.AccessTime, e.accessTime)
-	s.eiMutex.Lock()
-	s.extentInfoMap[extentID] = extInfo
-	s.eiMutex.Unlock()
+	s.extentInfoMap.Store(extentID, extInfo)
 
 	s.UpdateBaseExtentID(extentID)
 	return
@@ -431,45 +439,29 @@ func (s *ExtentStore) GetExtentInfoFromDisk(id uint64) (ei *ExtentInfo, err erro
 }
 
 func (s *ExtentStore) GetExtentInfo(id uint64) (ei *ExtentInfo, ok bool) {
-	s.eiMutex.RLock()
-	defer s.eiMutex.RUnlock()
-	ei, ok = s.extentInfoMap[id]
-	return
+	return s.extentInfoMap.Load(id)
 }
 
 // func (s *ExtentStore) SetExtentInfo(id uint64, ei *ExtentInfo) {
-// 	s.eiMutex.Lock()
-// 	defer s.eiMutex.Unlock()
-// 	s.extentInfoMap[id] = ei
+// 	s.extentInfoMap.Store(id, ei)
 // }
 
 func (s *ExtentStore) RangeExtentInfo(iter func(id uint64, ei *ExtentInfo) (ok bool, err error)) (err error) {
-	s.eiMutex.RLock()
-	defer s.eiMutex.RUnlock()
-
-	var ok bool
-	for id, v := range s.extentInfoMap {
+	s.extentInfoMap.Range(func(id uint64, v *ExtentInfo) bool {
+		var ok bool
 		ok, err = iter(id, v)
-		if err != nil || !ok {
-			return
-		}
-	}
+		return err == nil && ok
+	})
 	return
 }
 
 func (s *ExtentStore) DeleteExtentInfo(id uint64) {
-	s.eiMutex.Lock()
-	defer s.eiMutex.Unlock()
-
 	stat.RecordStat(s.partitionID, "DeleteExtentInfo", s.dataPath)
-	delete(s.extentInfoMap, id)
+	s.extentInfoMap.Delete(id)
 }
 
 func (s *ExtentStore) GetExtentInfoCount() (count int) {
-	s.eiMutex.RLock()
-	defer s.eiMutex.RUnlock()
-	count = len(s.extentInfoMap)
-	return
+	return s.extentInfoMap.Len()
 }
 
 func (s *ExtentStore) writeReadDirHint() (err error) {
@@ -600,7 +592,9 @@ func (s *ExtentStore) initBaseFileID() error {
 				baseFileID = id
 			}
 		}
-		s.extentInfoMap = extMap
+		for id, ei := range extMap {
+			s.extentInfoMap.Store(id, ei)
+		}
 	} else {
 		// NOTE: slow path
 		files, err := fileutil.ReadDir(s.dataPath)
@@ -622,7 +616,7 @@ func (s *ExtentStore) initBaseFileID() error {
 				log.LogErrorf("[initBaseFileID] store(%v) failed to load extent(%v), err(%v)", s.dataPath, extentID, err)
 				return err
 			}
-			s.extentInfoMap[extentID] = ei
+			s.extentInfoMap.Store(extentID, ei)
 
 			if !IsTinyExtent(extentID) && extentID > baseFileID {
 				baseFileID = extentID
@@ -677,10 +671,8 @@ func (s *ExtentStore) Write(param *WriteParam) (status uint8, err error) {
 	}
 	s.elMutex.RUnlock()
 
-	s.eiMutex.Lock()
 	status = proto.OpOk
-	ei = s.extentInfoMap[param.ExtentID]
-	s.eiMutex.Unlock()
+	ei, _ = s.extentInfoMap.Load(param.ExtentID)
 	e, err = s.extentWithHeader(ei)
 	if err != nil {
 		return status, err
@@ -800,11 +792,10 @@ func (s *ExtentStore) Read(extentID uint64, offset, size int64, nbuf []byte, isR
 }
 
 func (s *ExtentStore) DumpExtents() (extInfos SortedExtentInfos) {
-	s.eiMutex.RLock()
-	for _, v := range s.extentInfoMap {
+	s.extentInfoMap.Range(func(_ uint64, v *ExtentInfo) bool {
 		extInfos = append(extInfos, v)
-	}
-	s.eiMutex.RUnlock()
+		return true
+	})
 	return
 }
 
@@ -928,9 +919,7 @@ func (s *ExtentStore) MarkDelete(extentID uint64, offset, size int64) (err error
 	}
 	s.PutNormalExtentToDeleteCache(extentID)
 
-	s.eiMutex.Lock()
-	delete(s.extentInfoMap, extentID)
-	s.eiMutex.Unlock()
+	s.extentInfoMap.Delete(extentID)
 
 	return
 }
@@ -1057,11 +1046,10 @@ func (s *ExtentStore) getFileDiskUsed(name string) (size int64, err error) {
 
 func (s *ExtentStore) GetStoreUsedSize() (used int64) {
 	extentInfoSlice := make([]*ExtentInfo, 0, s.GetExtentCount())
-	s.eiMutex.RLock()
-	for _, extentID := range s.extentInfoMap {
-		extentInfoSlice = append(extentInfoSlice, extentID)
-	}
-	s.eiMutex.RUnlock()
+	s.extentInfoMap.Range(func(_ uint64, ei *ExtentInfo) bool {
+		extentInfoSlice = append(extentInfoSlice, ei)
+		return true
+	})
 	tinyTotal := uint64(0)
 	normalTotal := uint64(0)
 	for _, einfo := range extentInfoSlice {
@@ -1112,13 +1100,12 @@ func (s *ExtentStore) GetStoreUsedSize() (used int64) {
 
 // GetAllWatermarks returns all the watermarks.
 func (s *ExtentStore) GetAllWatermarks(filter ExtentFilter) (extents []*ExtentInfo, tinyDeleteFileSize int64, err error) {
-	extents = make([]*ExtentInfo, 0, len(s.extentInfoMap))
-	extentInfoSlice := make([]*ExtentInfo, 0, len(s.extentInfoMap))
-	s.eiMutex.RLock()
-	for _, extentID := range s.extentInfoMap {
-		extentInfoSlice = append(extentInfoSlice, extentID)
-	}
-	s.eiMutex.RUnlock()
+	extents = make([]*ExtentInfo, 0, s.extentInfoMap.Len())
+	extentInfoSlice := make([]*ExtentInfo, 0, s.extentInfoMap.Len())
+	s.extentInfoMap.Range(func(_ uint64, ei *ExtentInfo) bool {
+		extentInfoSlice = append(extentInfoSlice, ei)
+		return true
+	})
 
 	for _, extentInfo := range extentInfoSlice {
 		if filter != nil && !filter(extentInfo) {
@@ -1265,13 +1252,12 @@ func (s *ExtentStore) GetBrokenTinyExtent() (extentID uint64, err error) {
 // StoreSizeExtentID returns the size of the extent store
 func (s *ExtentStore) StoreSizeExtentID(maxExtentID uint64) (totalSize uint64) {
 	extentInfos := make([]*ExtentInfo, 0)
-	s.eiMutex.RLock()
-	for _, extentInfo := range s.extentInfoMap {
+	s.extentInfoMap.Range(func(_ uint64, extentInfo *ExtentInfo) bool {
 		if extentInfo.FileID <= maxExtentID {
 			extentInfos = append(extentInfos, extentInfo)
 		}
-	}
-	s.eiMutex.RUnlock()
+		return true
+	})
 	for _, extentInfo := range extentInfos {
 		totalSize += extentInfo.TotalSize()
 		log.LogDebugf("ExtentStore.StoreSizeExtentID dp %v extentInfo %v totalSize %v", s.partitionID, extentInfo, extentInfo.TotalSize())
@@ -1283,11 +1269,10 @@ func (s *ExtentStore) StoreSizeExtentID(maxExtentID uint64) (totalSize uint64) {
 // StoreSizeExtentID returns the size of the extent store
 func (s *ExtentStore) GetMaxExtentIDAndPartitionSize() (maxExtentID, totalSize uint64) {
 	extentInfos := make([]*ExtentInfo, 0)
-	s.eiMutex.RLock()
-	for _, extentInfo := range s.extentInfoMap {
+	s.extentInfoMap.Range(func(_ uint64, extentInfo *ExtentInfo) bool {
 		extentInfos = append(extentInfos, extentInfo)
-	}
-	s.eiMutex.RUnlock()
+		return true
+	})
 	for _, extentInfo := range extentInfos {
 		if extentInfo.FileID > maxExtentID {
 			maxExtentID = extentInfo.FileID
@@ -1435,16 +1420,21 @@ func (s *ExtentStore) HasExtent(extentID uint64) (exist bool) {
 	return
 }
 
+// GetExtentCacheStats returns the lookup and eviction counters of the
+// extent cache.
+func (s *ExtentStore) GetExtentCacheStats() ExtentCacheStats {
+	return s.cache.Stats()
+}
+
 // GetExtentCount returns the number of extents in the extentInfoMap
 func (s *ExtentStore) GetExtentCount() (count int) {
-	s.eiMutex.RLock()
-	defer s.eiMutex.RUnlock()
-	return len(s.extentInfoMap)
+	return s.extentInfoMap.Len()
 }
 
 func (s *ExtentStore) LoadExtentFromDisk(extentID uint64, putCache bool) (e *Extent, err error) {
 	name := path.Join(s.dataPath, fmt.Sprintf("%v", extentID))
 	e = NewExtentInCore(name, extentID)
+	e.engine = s.ioEngine
 	if err = e.RestoreFromFS(); err != nil {
 		if strings.Contains(err.Error(), ExtentNotFoundError.Error()) {
 			s.DeleteExtentInfo(extentID)
@@ -1564,21 +1554,16 @@ func (s *ExtentStore) autoComputeExtentCrc() {
 
 	extentInfos := make([]*ExtentInfo, 0)
 	deleteExtents := make([]*ExtentInfo, 0)
-	s.eiMutex.RLock()
-	for _, ei := range s.extentInfoMap {
+	s.extentInfoMap.Range(func(_ uint64, ei *ExtentInfo) bool {
 		extentInfos = append(extentInfos, ei)
 		if ei.IsDeleted && time.Now().Unix()-ei.ModifyTime > UpdateCrcInterval {
 			deleteExtents = append(deleteExtents, ei)
 		}
-	}
-	s.eiMutex.RUnlock()
+		return true
+	})
 
-	if len(deleteExtents) > 0 {
-		s.eiMutex.Lock()
-		for _, ei := range deleteExtents {
-			delete(s.extentInfoMap, ei.FileID)
-		}
-		s.eiMutex.Unlock()
+	for _, ei := range deleteExtents {
+		s.extentInfoMap.Delete(ei.FileID)
 	}
 
 	sort.Sort(ExtentInfoArr(extentInfos))
@@ -1664,9 +1649,7 @@ func (s *ExtentStore) TinyExtentGetFinfoSize(extentID uint64) (size uint64, err
 
 func (s *ExtentStore) GetExtentFinfoSize(extentID uint64) (size uint64, err error) {
 	var e *Extent
-	s.eiMutex.RLock()
-	ei := s.extentInfoMap[extentID]
-	s.eiMutex.RUnlock()
+	ei, _ := s.extentInfoMap.Load(extentID)
 	if e, err = s.extentWithHeader(ei); err != nil {
 		return
 	}
@@ -1682,9 +1665,7 @@ func (s *ExtentStore) GetExtentFinfoSize(extentID uint64) (size uint64, err erro
 
 func (s *ExtentStore) GetExtentWithHoleAvailableOffset(extentID uint64, offset int64) (newOffset, newEnd int64, err error) {
 	var e *Extent
-	s.eiMutex.RLock()
-	ei := s.extentInfoMap[extentID]
-	s.eiMutex.RUnlock()
+	ei, _ := s.extentInfoMap.Load(extentID)
 	if e, err = s.extentWithHeader(ei); err != nil {
 		return
 	}
@@ -1815,5 +1796,5 @@ func (s *ExtentStore) ExtentBatchUnlockNormalExtent(ext []*proto.ExtentKey) {
 }
 
 func (s *ExtentStore) GetExtentCountWithoutLock() (count int) {
-	return len(s.extentInfoMap)
+	return s.extentInfoMap.Len()
 }
@@ -294,3 +294,19 @@ func TestExtentStores(t *testing.T) {
 		ExtentStoreTest(t, ty)
 	}
 }
+
+func TestExtentStoreIOEngine(t *testing.T) {
+	for _, name := range []string{storage.IOEnginePsync, storage.IOEngineIOUring} {
+		engine, err := storage.NewIOEngine(name)
+		require.NoError(t, err)
+		engine = storage.WithGroupCommit(engine, 0)
+		path, clean, err := getTestPathExtentStore()
+		require.NoError(t, err)
+		s, err := storage.NewExtentStoreWithIOEngine(path, 0, 1*util.GB, proto.PartitionTypeNormal, 0, true, engine)
+		require.NoError(t, err)
+		extentStoreLogicalTest(t, s)
+		s.Close()
+		engine.Close()
+		clean()
+	}
+}
@@ -17,12 +17,14 @@ package storage_test
 import (
 	"bytes"
 	"fmt"
+	"hash/crc32"
 	"os"
 	"syscall"
 	"testing"
 
 	"github.com/cubefs/cubefs/blobstore/blobnode/sys"
 	"github.com/cubefs/cubefs/datanode/storage"
+	"github.com/cubefs/cubefs/proto"
 	"github.com/cubefs/cubefs/util"
 	"github.com/stretchr/testify/require"
 )
@@ -231,6 +233,95 @@ func TestNormalExtent(t *testing.T) {
 	normalExtentRecoveryTest(t, name)
 }
 
+func TestExtentAppendBlockCrc(t *testing.T) {
+	name, clean, err := getTestPathExtentName(testNormalExtentID)
+	require.NoError(t, err)
+	defer clean()
+	e := storage.NewExtentInCore(name, testNormalExtentID)
+	require.NoError(t, e.InitToFS())
+	defer e.Close()
+
+	crcs := make(map[int]uint32)
+	crcFunc := func(e *storage.Extent, blockNo int, crc uint32) error {
+		crcs[blockNo] = crc
+		return nil
+	}
+	block := bytes.Repeat([]byte("0123456789"), util.BlockSize/10+1)[:util.BlockSize]
+	// unaligned appends fill block 0 and start block 1
+	offset := 0
+	for _, size := range []int{1000, 50000, util.BlockSize - 51000, 4096} {
+		data := block[offset%util.BlockSize : offset%util.BlockSize+size]
+		param := &storage.WriteParam{
+			ExtentID:  testNormalExtentID,
+			Offset:    int64(offset),
+			Size:      int64(size),
+			Data:      data,
+			Crc:       crc32.ChecksumIEEE(data),
+			WriteType: storage.AppendWriteType,
+		}
+		_, err = e.Write(param, crcFunc)
+		require.NoError(t, err)
+		offset += size
+	}
+	require.Equal(t, crc32.ChecksumIEEE(block), crcs[0])
+	require.EqualValues(t, 0, crcs[1])
+
+	// an overwrite of the tail block drops its running crc
+	param := &storage.WriteParam{
+		ExtentID:  testNormalExtentID,
+		Offset:    int64(util.BlockSize + 100),
+		Size:      10,
+		Data:      block[:10],
+		WriteType: storage.RandomWriteType,
+	}
+	_, err = e.Write(param, crcFunc)
+	require.NoError(t, err)
+	param = &storage.WriteParam{
+		ExtentID:  testNormalExtentID,
+		Offset:    int64(offset),
+		Size:      int64(2*util.BlockSize - offset),
+		Data:      block[:2*util.BlockSize-offset],
+		WriteType: storage.AppendWriteType,
+	}
+	_, err = e.Write(param, crcFunc)
+	require.NoError(t, err)
+	require.EqualValues(t, 0, crcs[1])
+
+	// so does a hole punched in the tail block by a delete
+	path, cleanStore, err := getTestPathExtentStore()
+	require.NoError(t, err)
+	defer cleanStore()
+	s, err := storage.NewExtentStore(path, 0, 1*util.GB, proto.PartitionTypeNormal, 0, true)
+	require.NoError(t, err)
+	defer s.Close()
+	id, err := s.NextExtentID()
+	require.NoError(t, err)
+	require.NoError(t, s.Create(id))
+	offset = 0
+	write := func(size int) {
+		data := block[offset%util.BlockSize : offset%util.BlockSize+size]
+		_, err := s.Write(&storage.WriteParam{
+			ExtentID:  id,
+			Offset:    int64(offset),
+			Size:      int64(size),
+			Data:      data,
+			Crc:       crc32.ChecksumIEEE(data),
+			WriteType: storage.AppendWriteType,
+		})
+		require.NoError(t, err)
+		offset += size
+	}
+	write(util.BlockSize)
+	write(8192)
+	require.NoError(t, s.MarkDelete(id, util.BlockSize, 4096))
+	write(util.BlockSize - 8192)
+	bcs, err := s.ScanBlocks(id)
+	require.NoError(t, err)
+	require.Len(t, bcs, 2)
+	require.Equal(t, crc32.ChecksumIEEE(block), bcs[0].Crc)
+	require.EqualValues(t, 0, bcs[1].Crc)
+}
+
 func TestSeekHole(t *testing.T) {
 	var (
 		info     os.FileInfo
@@ -342,3 +433,24 @@ func TestExtentRecovery(t *testing.T) {
 	t.Logf("dataSize %v, snapSize %v", dataSize, snapSize)
 	require.True(t, util.BlockSize*10 == dataSize)
 }
+
+// BenchmarkBlockCrc reports the crc throughput of a core over blocks, for
+// the IEEE polynomial used by the extents and for Castagnoli.
+func BenchmarkBlockCrc(b *testing.B) {
+	tables := []struct {
+		name  string
+		table *crc32.Table
+	}{
+		{"ieee", crc32.IEEETable},
+		{"castagnoli", crc32.MakeTable(crc32.Castagnoli)},
+	}
+	data := bytes.Repeat([]byte{0x5a}, util.BlockSize)
+	for _, tt := range tables {
+		b.Run(tt.name, func(b *testing.B) {
+			b.SetBytes(int64(len(data)))
+			for i := 0; i < b.N; i++ {
+				crc32.Checksum(data, tt.table)
+			}
+		})
+	}
+}
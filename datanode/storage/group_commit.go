@@ -0,0 +1,168 @@
+// Copyright 2024 The CubeFS Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+
+package storage
+
+import (
+	"os"
+	"sync"
+	"sync/atomic"
+	"syscall"
+	"time"
+
+	"github.com/cubefs/cubefs/util/log"
+)
+
+type syncBatch struct {
+	files map[*os.File]error
+	done  chan struct{}
+}
+
+func newSyncBatch() *syncBatch {
+	return &syncBatch{
+		files: make(map[*os.File]error),
+		done:  make(chan struct{}),
+	}
+}
+
+// groupCommitEngine commits the syncs of the extents of a disk in groups. A
+// sync joins the batch being collected and waits for it. A single flusher
+// takes the batch once the previous one is committed, after waiting window
+// for more syncs if window is set, syncs each of its files once with
+// fdatasync and releases the waiters. So the concurrent sync writes of a
+// disk cost about a fdatasync per file and batch instead of one per write.
+type groupCommitEngine struct {
+	IOEngine
+	window time.Duration
+
+	mu    sync.Mutex
+	batch *syncBatch
+	kickC chan struct{}
+	stopC chan struct{}
+	wg    sync.WaitGroup
+
+	syncs   uint64 // Sync calls
+	commits uint64 // fdatasync calls
+}
+
+// WithGroupCommit returns engine with its syncs committed in groups.
+func WithGroupCommit(engine IOEngine, window time.Duration) IOEngine {
+	g := &groupCommitEngine{
+		IOEngine: engine,
+		window:   window,
+		batch:    newSyncBatch(),
+		kickC:    make(chan struct{}, 1),
+		stopC:    make(chan struct{}),
+	}
+	g.wg.Add(1)
+	go g.flushLoop()
+	return g
+}
+
+func (g *groupCommitEngine) Sync(f *os.File) error {
+	atomic.AddUint64(&g.syncs, 1)
+	g.mu.Lock()
+	b := g.batch
+	b.files[f] = nil
+	g.mu.Unlock()
+	select {
+	case g.kickC <- struct{}{}:
+	default:
+	}
+	<-b.done
+	return b.files[f]
+}
+
+// Close stops the flusher and closes the wrapped engine, the engine must not
+// be used afterwards.
+func (g *groupCommitEngine) Close() error {
+	close(g.stopC)
+	g.wg.Wait()
+	return g.IOEngine.Close()
+}
+
+func (g *groupCommitEngine) flushLoop() {
+	defer g.wg.Done()
+	for {
+		select {
+		case <-g.kickC:
+		case <-g.stopC:
+			g.commit()
+			return
+		}
+		if g.window > 0 {
+			time.Sleep(g.window)
+		}
+		g.commit()
+	}
+}
+
+func (g *groupCommitEngine) commit() {
+	g.mu.Lock()
+	b := g.batch
+	g.batch = newSyncBatch()
+	g.mu.Unlock()
+
+	if len(b.files) == 1 {
+		for f := range b.files {
+			b.files[f] = fdatasync(f)
+		}
+	} else if len(b.files) > 1 {
+		// the files are synced concurrently, which lets the device merge
+		// the flushes
+		var (
+			wg   sync.WaitGroup
+			mu   sync.Mutex
+			errs = make(map[*os.File]error)
+		)
+		for f := range b.files {
+			wg.Add(1)
+			go func(f *os.File) {
+				defer wg.Done()
+				if err := fdatasync(f); err != nil {
+					mu.Lock()
+					errs[f] = err
+					mu.Unlock()
+				}
+			}(f)
+		}
+		wg.Wait()
+		for f, err := range errs {
+			b.files[f] = err
+		}
+	}
+	atomic.AddUint64(&g.commits, uint64(len(b.files)))
+	close(b.done)
+}
+
+func fdatasync(f *os.File) (err error) {
+	conn, err := f.SyscallConn()
+	if err != nil {
+		return
+	}
+	if cerr := conn.Control(func(fd uintptr) {
+		for {
+			if err = syscall.Fdatasync(int(fd)); err != syscall.EINTR {
+				return
+			}
+		}
+	}); cerr != nil {
+		err = cerr
+	}
+	if err != nil {
+		log.LogErrorf("groupCommitEngine: fdatasync file(%v) err(%v)", f.Name(), err)
+		err = &os.PathError{Op: "fdatasync", Path: f.Name(), Err: err}
+	}
+	return
+}
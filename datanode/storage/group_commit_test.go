@@ -0,0 +1,112 @@
+// Copyright 2024 The CubeFS Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+
+package storage
+
+import (
+	"fmt"
+	"os"
+	"path/filepath"
+	"sync"
+	"sync/atomic"
+	"testing"
+	"time"
+
+	"github.com/stretchr/testify/require"
+)
+
+func createSyncTestFiles(t testing.TB, n int) []*os.File {
+	dir := t.TempDir()
+	files := make([]*os.File, n)
+	for i := range files {
+		f, err := os.Create(filepath.Join(dir, fmt.Sprint(i)))
+		require.NoError(t, err)
+		files[i] = f
+	}
+	return files
+}
+
+func TestGroupCommit(t *testing.T) {
+	files := createSyncTestFiles(t, 4)
+	engine := WithGroupCommit(psyncEngine{}, 100*time.Microsecond)
+	g := engine.(*groupCommitEngine)
+
+	const writers = 64
+	var wg sync.WaitGroup
+	for i := 0; i < writers; i++ {
+		wg.Add(1)
+		go func(i int) {
+			defer wg.Done()
+			f := files[i%len(files)]
+			_, err := engine.WriteAt(f, []byte{byte(i)}, int64(i))
+			require.NoError(t, err)
+			require.NoError(t, engine.Sync(f))
+		}(i)
+	}
+	wg.Wait()
+	require.EqualValues(t, writers, atomic.LoadUint64(&g.syncs))
+	require.LessOrEqual(t, atomic.LoadUint64(&g.commits), uint64(writers))
+	t.Logf("syncs(%v) commits(%v)", g.syncs, g.commits)
+
+	require.NoError(t, engine.Close())
+	for _, f := range files {
+		f.Close()
+	}
+
+	// the errors are returned to the waiters of the file
+	engine = WithGroupCommit(psyncEngine{}, 0)
+	require.Error(t, engine.Sync(files[0]))
+	require.NoError(t, engine.Close())
+}
+
+// BenchmarkSyncWrite writes and syncs 4KB blocks of 4 files from 32
+// goroutines per CPU.
+func BenchmarkSyncWrite(b *testing.B) {
+	const block = 4096
+	files := createSyncTestFiles(b, 4)
+	defer func() {
+		for _, f := range files {
+			f.Close()
+		}
+	}()
+
+	engines := map[string]IOEngine{
+		"inline":       psyncEngine{},
+		"group-commit": WithGroupCommit(psyncEngine{}, 0),
+	}
+	for _, name := range []string{"inline", "group-commit"} {
+		engine := engines[name]
+		b.Run(name, func(b *testing.B) {
+			var next uint64
+			b.SetBytes(block)
+			b.SetParallelism(32)
+			b.RunParallel(func(pb *testing.PB) {
+				data := make([]byte, block)
+				for pb.Next() {
+					i := atomic.AddUint64(&next, 1)
+					f := files[i%uint64(len(files))]
+					if _, err := engine.WriteAt(f, data, int64(i/uint64(len(files))%1024*block)); err != nil {
+						b.Error(err)
+						return
+					}
+					if err := engine.Sync(f); err != nil {
+						b.Error(err)
+						return
+					}
+				}
+			})
+		})
+		engine.Close()
+	}
+}
@@ -0,0 +1,83 @@
+// Copyright 2024 The CubeFS Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+
+package storage
+
+import (
+	"fmt"
+	"os"
+
+	"github.com/cubefs/cubefs/util/log"
+)
+
+const (
+	IOEnginePsync   = "psync"
+	IOEngineIOUring = "io_uring"
+
+	// number of requests an io_uring engine keeps in flight
+	ioUringEntries = 256
+)
+
+// IOEngine performs the positioned reads and writes and the syncs of the
+// extent files of a disk. Like os.File, ReadAt returns an error when it
+// reads less than len(b) bytes, and WriteAt when it writes less than len(b)
+// bytes.
+type IOEngine interface {
+	ReadAt(f *os.File, b []byte, off int64) (n int, err error)
+	WriteAt(f *os.File, b []byte, off int64) (n int, err error)
+	Sync(f *os.File) error
+	Name() string
+	Close() error
+}
+
+// psyncEngine issues a pread or pwrite per request from the calling
+// goroutine.
+type psyncEngine struct{}
+
+func (psyncEngine) ReadAt(f *os.File, b []byte, off int64) (int, error) {
+	return f.ReadAt(b, off)
+}
+
+func (psyncEngine) WriteAt(f *os.File, b []byte, off int64) (int, error) {
+	return f.WriteAt(b, off)
+}
+
+func (psyncEngine) Sync(f *os.File) error {
+	return f.Sync()
+}
+
+func (psyncEngine) Name() string {
+	return IOEnginePsync
+}
+
+func (psyncEngine) Close() error {
+	return nil
+}
+
+// NewIOEngine returns the engine called name, psync if name is empty. When
+// io_uring is not supported by the kernel, it falls back to psync.
+func NewIOEngine(name string) (IOEngine, error) {
+	switch name {
+	case "", IOEnginePsync:
+		return psyncEngine{}, nil
+	case IOEngineIOUring:
+		engine, err := newIOUringEngine(ioUringEntries)
+		if err != nil {
+			log.LogWarnf("NewIOEngine: io_uring is not available, fall back to psync, err(%v)", err)
+			return psyncEngine{}, nil
+		}
+		return engine, nil
+	}
+	return nil, fmt.Errorf("unknown io engine %v", name)
+}
@@ -0,0 +1,165 @@
+// Copyright 2024 The CubeFS Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+
+package storage
+
+import (
+	"bytes"
+	"fmt"
+	"io"
+	"math/rand"
+	"os"
+	"path/filepath"
+	"sync"
+	"syscall"
+	"testing"
+
+	"github.com/stretchr/testify/require"
+)
+
+func testIOEngine(t *testing.T, engine IOEngine) {
+	f, err := os.Create(filepath.Join(t.TempDir(), "extent"))
+	require.NoError(t, err)
+	defer f.Close()
+
+	const (
+		writers = 16
+		block   = 4096
+	)
+	var wg sync.WaitGroup
+	for i := 0; i < writers; i++ {
+		wg.Add(1)
+		go func(i int) {
+			defer wg.Done()
+			data := bytes.Repeat([]byte{byte(i)}, block)
+			n, err := engine.WriteAt(f, data, int64(i*block))
+			require.NoError(t, err)
+			require.Equal(t, block, n)
+		}(i)
+	}
+	wg.Wait()
+
+	for i := 0; i < writers; i++ {
+		wg.Add(1)
+		go func(i int) {
+			defer wg.Done()
+			data := make([]byte, block)
+			n, err := engine.ReadAt(f, data, int64(i*block))
+			require.NoError(t, err)
+			require.Equal(t, block, n)
+			require.Equal(t, bytes.Repeat([]byte{byte(i)}, block), data)
+		}(i)
+	}
+	wg.Wait()
+
+	data := make([]byte, 2*block)
+	n, err := engine.ReadAt(f, data, (writers-1)*block)
+	require.Equal(t, io.EOF, err)
+	require.Equal(t, block, n)
+
+	n, err = engine.ReadAt(f, data[:0], 0)
+	require.NoError(t, err)
+	require.Equal(t, 0, n)
+}
+
+func TestIOEngine(t *testing.T) {
+	for _, name := range []string{IOEnginePsync, IOEngineIOUring} {
+		t.Run(name, func(t *testing.T) {
+			engine, err := NewIOEngine(name)
+			require.NoError(t, err)
+			defer engine.Close()
+			if engine.Name() != name {
+				t.Skipf("%v is not available", name)
+			}
+			testIOEngine(t, engine)
+		})
+	}
+	_, err := NewIOEngine("aio")
+	require.Error(t, err)
+}
+
+// failSyncEngine fails the syncs while err is set.
+type failSyncEngine struct {
+	psyncEngine
+	err error
+}
+
+func (e *failSyncEngine) Sync(f *os.File) error {
+	if e.err != nil {
+		return e.err
+	}
+	return e.psyncEngine.Sync(f)
+}
+
+func TestExtentSyncWriteError(t *testing.T) {
+	e := NewExtentInCore(filepath.Join(t.TempDir(), "1"), 1)
+	require.NoError(t, e.InitToFS())
+	defer e.Close()
+	engine := &failSyncEngine{err: syscall.EIO}
+	e.engine = engine
+
+	data := bytes.Repeat([]byte{1}, 4096)
+	param := &WriteParam{Data: data, Size: int64(len(data)), WriteType: RandomWriteType, IsSync: true}
+	// the extent stays dirty if the sync of a write fails, so Flush syncs it
+	_, err := e.Write(param, nil)
+	require.Equal(t, syscall.EIO, err)
+	require.True(t, e.dirty.Load())
+	engine.err = nil
+	require.NoError(t, e.Flush())
+	require.False(t, e.dirty.Load())
+
+	// and is clean once it succeeds
+	param.IsSync = false
+	_, err = e.Write(param, nil)
+	require.NoError(t, err)
+	require.True(t, e.dirty.Load())
+	param.IsSync = true
+	_, err = e.Write(param, nil)
+	require.NoError(t, err)
+	require.False(t, e.dirty.Load())
+}
+
+// BenchmarkIOEngineRead reads random 4KB blocks of a file in the page cache
+// from 64 goroutines per CPU.
+func BenchmarkIOEngineRead(b *testing.B) {
+	const (
+		fileSize = 64 << 20
+		block    = 4096
+	)
+	f, err := os.Create(filepath.Join(b.TempDir(), "extent"))
+	require.NoError(b, err)
+	defer f.Close()
+	_, err = f.WriteAt(make([]byte, fileSize), 0)
+	require.NoError(b, err)
+
+	for _, name := range []string{IOEnginePsync, IOEngineIOUring} {
+		engine, err := NewIOEngine(name)
+		require.NoError(b, err)
+		b.Run(fmt.Sprintf("engine-%s", engine.Name()), func(b *testing.B) {
+			b.SetBytes(block)
+			b.SetParallelism(64)
+			b.RunParallel(func(pb *testing.PB) {
+				data := make([]byte, block)
+				rnd := rand.New(rand.NewSource(rand.Int63()))
+				for pb.Next() {
+					if _, err := engine.ReadAt(f, data, rnd.Int63n(fileSize/block)*block); err != nil {
+						b.Error(err)
+						return
+					}
+				}
+			})
+		})
+		engine.Close()
+	}
+}
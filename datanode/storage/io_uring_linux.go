@@ -0,0 +1,416 @@
+// Copyright 2024 The CubeFS Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+
+package storage
+
+import (
+	"io"
+	"os"
+	"sync"
+	"sync/atomic"
+	"syscall"
+	"time"
+	"unsafe"
+
+	"github.com/cubefs/cubefs/util/log"
+	"golang.org/x/sys/unix"
+)
+
+const (
+	ioringOffSQRing = 0
+	ioringOffCQRing = 0x8000000
+	ioringOffSQEs   = 0x10000000
+
+	// readv and writev are supported since the first io_uring kernel, 5.1
+	ioringOpReadv  = 1
+	ioringOpWritev = 2
+
+	ioringEnterGetEvents = 1
+)
+
+type ioSQRingOffsets struct {
+	head        uint32
+	tail        uint32
+	ringMask    uint32
+	ringEntries uint32
+	flags       uint32
+	dropped     uint32
+	array       uint32
+	resv1       uint32
+	userAddr    uint64
+}
+
+type ioCQRingOffsets struct {
+	head        uint32
+	tail        uint32
+	ringMask    uint32
+	ringEntries uint32
+	overflow    uint32
+	cqes        uint32
+	flags       uint32
+	resv1       uint32
+	userAddr    uint64
+}
+
+type ioUringParams struct {
+	sqEntries    uint32
+	cqEntries    uint32
+	flags        uint32
+	sqThreadCPU  uint32
+	sqThreadIdle uint32
+	features     uint32
+	wqFd         uint32
+	resv         [3]uint32
+	sqOff        ioSQRingOffsets
+	cqOff        ioCQRingOffsets
+}
+
+type ioUringSQE struct {
+	opcode   uint8
+	flags    uint8
+	ioprio   uint16
+	fd       int32
+	off      uint64
+	addr     uint64
+	len      uint32
+	rwFlags  uint32
+	userData uint64
+	pad      [3]uint64
+}
+
+type ioUringCQE struct {
+	userData uint64
+	res      int32
+	flags    uint32
+}
+
+type ioUringRequest struct {
+	opcode uint8
+	fd     int32
+	off    uint64
+	iov    syscall.Iovec
+	res    int32
+	done   chan struct{}
+}
+
+var ioUringRequestPool = sync.Pool{
+	New: func() interface{} {
+		return &ioUringRequest{done: make(chan struct{}, 1)}
+	},
+}
+
+// ioUringEngine submits the reads and writes of a disk through an io_uring.
+// The callers queue their requests to a single goroutine, which submits
+// every request queued meanwhile with one io_uring_enter call and waits for
+// the completions in the same call. So the requests of a disk cost about a
+// syscall per batch instead of one per request, and a blocked thread per
+// disk instead of one per request in flight.
+type ioUringEngine struct {
+	fd      int
+	entries uint32
+
+	sqRing  []byte
+	cqRing  []byte
+	sqeMem  []byte
+	sqTail  *uint32
+	sqMask  uint32
+	sqArray []uint32
+	sqes    []ioUringSQE
+	cqHead  *uint32
+	cqTail  *uint32
+	cqMask  uint32
+	cqes    []ioUringCQE
+
+	// slots holds the requests in flight by user data, it's only used by
+	// the submit loop
+	slots []*ioUringRequest
+	free  []uint64
+
+	reqC  chan *ioUringRequest
+	stopC chan struct{}
+	wg    sync.WaitGroup
+}
+
+func newIOUringEngine(entries uint32) (IOEngine, error) {
+	r, err := setupIOUring(entries)
+	if err != nil {
+		return nil, err
+	}
+	r.wg.Add(1)
+	go r.loop()
+	return r, nil
+}
+
+// setupIOUring creates the ring of an engine, the submit loop is not started.
+func setupIOUring(entries uint32) (*ioUringEngine, error) {
+	var p ioUringParams
+	fd, _, errno := syscall.Syscall(unix.SYS_IO_URING_SETUP, uintptr(entries), uintptr(unsafe.Pointer(&p)), 0)
+	if errno != 0 {
+		return nil, os.NewSyscallError("io_uring_setup", errno)
+	}
+	r := &ioUringEngine{
+		fd:      int(fd),
+		entries: p.sqEntries,
+		reqC:    make(chan *ioUringRequest, p.sqEntries),
+		stopC:   make(chan struct{}),
+	}
+	if err := r.mmap(&p); err != nil {
+		r.unmap()
+		syscall.Close(r.fd)
+		return nil, err
+	}
+	r.slots = make([]*ioUringRequest, r.entries)
+	r.free = make([]uint64, 0, r.entries)
+	for i := uint64(0); i < uint64(r.entries); i++ {
+		r.free = append(r.free, i)
+	}
+	return r, nil
+}
+
+func (r *ioUringEngine) mmap(p *ioUringParams) (err error) {
+	prot := syscall.PROT_READ | syscall.PROT_WRITE
+	flags := syscall.MAP_SHARED | syscall.MAP_POPULATE
+	if r.sqRing, err = syscall.Mmap(r.fd, ioringOffSQRing, int(p.sqOff.array+p.sqEntries*4), prot, flags); err != nil {
+		return os.NewSyscallError("mmap", err)
+	}
+	cqSize := int(p.cqOff.cqes) + int(p.cqEntries)*int(unsafe.Sizeof(ioUringCQE{}))
+	if r.cqRing, err = syscall.Mmap(r.fd, ioringOffCQRing, cqSize, prot, flags); err != nil {
+		return os.NewSyscallError("mmap", err)
+	}
+	sqeSize := int(p.sqEntries) * int(unsafe.Sizeof(ioUringSQE{}))
+	if r.sqeMem, err = syscall.Mmap(r.fd, ioringOffSQEs, sqeSize, prot, flags); err != nil {
+		return os.NewSyscallError("mmap", err)
+	}
+
+	r.sqTail = (*uint32)(unsafe.Pointer(&r.sqRing[p.sqOff.tail]))
+	r.sqMask = *(*uint32)(unsafe.Pointer(&r.sqRing[p.sqOff.ringMask]))
+	r.sqArray = unsafe.Slice((*uint32)(unsafe.Pointer(&r.sqRing[p.sqOff.array])), p.sqEntries)
+	r.sqes = unsafe.Slice((*ioUringSQE)(unsafe.Pointer(&r.sqeMem[0])), p.sqEntries)
+	r.cqHead = (*uint32)(unsafe.Pointer(&r.cqRing[p.cqOff.head]))
+	r.cqTail = (*uint32)(unsafe.Pointer(&r.cqRing[p.cqOff.tail]))
+	r.cqMask = *(*uint32)(unsafe.Pointer(&r.cqRing[p.cqOff.ringMask]))
+	r.cqes = unsafe.Slice((*ioUringCQE)(unsafe.Pointer(&r.cqRing[p.cqOff.cqes])), p.cqEntries)
+	return nil
+}
+
+func (r *ioUringEngine) unmap() {
+	for _, m := range [][]byte{r.sqRing, r.cqRing, r.sqeMem} {
+		if m != nil {
+			syscall.Munmap(m)
+		}
+	}
+}
+
+func (r *ioUringEngine) Name() string {
+	return IOEngineIOUring
+}
+
+// Close stops the engine once the requests in flight are completed, the
+// engine must not be used afterwards.
+func (r *ioUringEngine) Close() error {
+	close(r.stopC)
+	r.wg.Wait()
+	r.unmap()
+	return syscall.Close(r.fd)
+}
+
+func (r *ioUringEngine) Sync(f *os.File) error {
+	return f.Sync()
+}
+
+func (r *ioUringEngine) ReadAt(f *os.File, b []byte, off int64) (n int, err error) {
+	for n < len(b) {
+		var m int
+		if m, err = r.do(ioringOpReadv, f, b[n:], off+int64(n)); err != nil {
+			return n, &os.PathError{Op: "read", Path: f.Name(), Err: err}
+		}
+		if m == 0 {
+			return n, io.EOF
+		}
+		n += m
+	}
+	return
+}
+
+func (r *ioUringEngine) WriteAt(f *os.File, b []byte, off int64) (n int, err error) {
+	for n < len(b) {
+		var m int
+		if m, err = r.do(ioringOpWritev, f, b[n:], off+int64(n)); err != nil {
+			return n, &os.PathError{Op: "write", Path: f.Name(), Err: err}
+		}
+		if m == 0 {
+			return n, io.ErrShortWrite
+		}
+		n += m
+	}
+	return
+}
+
+func (r *ioUringEngine) do(opcode uint8, f *os.File, b []byte, off int64) (n int, err error) {
+	conn, err := f.SyscallConn()
+	if err != nil {
+		return
+	}
+	req := ioUringRequestPool.Get().(*ioUringRequest)
+	req.opcode = opcode
+	req.off = uint64(off)
+	req.iov.Base = &b[0]
+	req.iov.SetLen(len(b))
+	// the request is queued and completed while the file is referenced, so
+	// that a concurrent Close can't release the descriptor and let another
+	// file reuse it before the kernel picks the request up
+	if cerr := conn.Control(func(fd uintptr) {
+		req.fd = int32(fd)
+		for {
+			r.reqC <- req
+			<-req.done
+			if req.res != -int32(syscall.EINTR) && req.res != -int32(syscall.EAGAIN) {
+				return
+			}
+		}
+	}); cerr != nil {
+		// Control only fails once the file is closed, report it like
+		// os.File does
+		err = os.ErrClosed
+	} else if req.res < 0 {
+		err = syscall.Errno(-req.res)
+	} else {
+		n = int(req.res)
+	}
+	req.iov.Base = nil
+	ioUringRequestPool.Put(req)
+	return
+}
+
+func (r *ioUringEngine) loop() {
+	defer r.wg.Done()
+	var (
+		batch    []*ioUringRequest
+		inflight int
+		stopped  bool
+	)
+	for {
+		if inflight == 0 {
+			if stopped {
+				return
+			}
+			// wait for a request
+			select {
+			case req := <-r.reqC:
+				batch = append(batch, req)
+			case <-r.stopC:
+				stopped = true
+				continue
+			}
+		}
+	collect:
+		for inflight+len(batch) < int(r.entries) {
+			select {
+			case req := <-r.reqC:
+				batch = append(batch, req)
+			default:
+				break collect
+			}
+		}
+		for _, req := range batch {
+			r.prepare(req)
+		}
+		failed := r.enter(uint32(len(batch)))
+		inflight += len(batch) - failed
+		batch = batch[:0]
+		inflight -= r.reap()
+	}
+}
+
+// prepare queues req to the submission ring.
+func (r *ioUringEngine) prepare(req *ioUringRequest) {
+	slot := r.free[len(r.free)-1]
+	r.free = r.free[:len(r.free)-1]
+	r.slots[slot] = req
+
+	tail := *r.sqTail
+	index := tail & r.sqMask
+	r.sqes[index] = ioUringSQE{
+		opcode:   req.opcode,
+		fd:       req.fd,
+		off:      req.off,
+		addr:     uint64(uintptr(unsafe.Pointer(&req.iov))),
+		len:      1,
+		userData: slot,
+	}
+	r.sqArray[index] = index
+	atomic.StoreUint32(r.sqTail, tail+1)
+}
+
+// enter submits toSubmit requests and waits for at least one completion.
+// The requests it fails to submit for a persistent error are completed with
+// the error, and their count is returned.
+func (r *ioUringEngine) enter(toSubmit uint32) int {
+	for {
+		n, _, errno := syscall.Syscall6(unix.SYS_IO_URING_ENTER, uintptr(r.fd), uintptr(toSubmit), 1,
+			ioringEnterGetEvents, 0, 0)
+		switch errno {
+		case 0:
+			if toSubmit -= uint32(n); toSubmit == 0 {
+				return 0
+			}
+		case syscall.EINTR, syscall.EAGAIN, syscall.EBUSY:
+		default:
+			log.LogErrorf("ioUringEngine enter: fd(%v) submit(%v) err(%v)", r.fd, toSubmit, errno)
+			if toSubmit == 0 {
+				// only the wait failed, the loop waits again
+				time.Sleep(time.Millisecond)
+				return 0
+			}
+			r.fail(toSubmit, errno)
+			return int(toSubmit)
+		}
+	}
+}
+
+// fail takes the last count requests, which the kernel did not pick up, off
+// the submission ring and completes them with errno.
+func (r *ioUringEngine) fail(count uint32, errno syscall.Errno) {
+	tail := *r.sqTail - count
+	reqs := make([]*ioUringRequest, 0, count)
+	for i := tail; i != *r.sqTail; i++ {
+		slot := r.sqes[i&r.sqMask].userData
+		reqs = append(reqs, r.slots[slot])
+		r.slots[slot] = nil
+		r.free = append(r.free, slot)
+	}
+	atomic.StoreUint32(r.sqTail, tail)
+	for _, req := range reqs {
+		req.res = -int32(errno)
+		req.done <- struct{}{}
+	}
+}
+
+// reap completes the requests in the completion ring and returns their
+// count.
+func (r *ioUringEngine) reap() (n int) {
+	head := *r.cqHead
+	tail := atomic.LoadUint32(r.cqTail)
+	for ; head != tail; head++ {
+		cqe := &r.cqes[head&r.cqMask]
+		req := r.slots[cqe.userData]
+		r.slots[cqe.userData] = nil
+		r.free = append(r.free, cqe.userData)
+		req.res = cqe.res
+		req.done <- struct{}{}
+		n++
+	}
+	atomic.StoreUint32(r.cqHead, head)
+	return
+}
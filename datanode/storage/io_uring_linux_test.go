@@ -0,0 +1,95 @@
+// Copyright 2024 The CubeFS Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+
+package storage
+
+import (
+	"bytes"
+	"os"
+	"path/filepath"
+	"syscall"
+	"testing"
+	"time"
+
+	"github.com/stretchr/testify/require"
+)
+
+func TestIOUringCloseWhileQueued(t *testing.T) {
+	r, err := setupIOUring(8)
+	if err != nil {
+		t.Skipf("io_uring is not available: %v", err)
+	}
+	const block = 4096
+	dir := t.TempDir()
+	f, err := os.Create(filepath.Join(dir, "1"))
+	require.NoError(t, err)
+	_, err = f.Write(bytes.Repeat([]byte{'a'}, block))
+	require.NoError(t, err)
+
+	// the submit loop is not started, so the read stays queued
+	errC := make(chan error, 1)
+	data := make([]byte, block)
+	go func() {
+		_, err := r.ReadAt(f, data, 0)
+		errC <- err
+	}()
+	for len(r.reqC) == 0 {
+		time.Sleep(time.Millisecond)
+	}
+	require.NoError(t, f.Close())
+
+	// a file opened meanwhile must not take over the descriptor of the
+	// queued read
+	g, err := os.Create(filepath.Join(dir, "2"))
+	require.NoError(t, err)
+	defer g.Close()
+	_, err = g.Write(bytes.Repeat([]byte{'b'}, block))
+	require.NoError(t, err)
+
+	r.wg.Add(1)
+	go r.loop()
+	require.NoError(t, <-errC)
+	require.Equal(t, bytes.Repeat([]byte{'a'}, block), data)
+
+	// the requests on a closed file fail like with psync
+	_, err = r.ReadAt(f, data, 0)
+	require.ErrorIs(t, err, os.ErrClosed)
+	require.NoError(t, r.Close())
+}
+
+func TestIOUringSubmitError(t *testing.T) {
+	r, err := setupIOUring(8)
+	if err != nil {
+		t.Skipf("io_uring is not available: %v", err)
+	}
+	f, err := os.Create(filepath.Join(t.TempDir(), "1"))
+	require.NoError(t, err)
+	defer f.Close()
+
+	// io_uring_enter fails on a descriptor which is not a ring, the requests
+	// fail with its error instead of hanging
+	ringFd := r.fd
+	r.fd = int(f.Fd())
+	r.wg.Add(1)
+	go r.loop()
+	_, err = r.WriteAt(f, make([]byte, 4096), 0)
+	require.ErrorIs(t, err, syscall.EOPNOTSUPP)
+	require.Len(t, r.free, int(r.entries))
+
+	r.fd = ringFd
+	n, err := r.WriteAt(f, make([]byte, 4096), 0)
+	require.NoError(t, err)
+	require.Equal(t, 4096, n)
+	require.NoError(t, r.Close())
+}
@@ -146,6 +146,18 @@ type ExtentConfig struct {
 
 	OnGetInodeInfo      GetInodeInfoFunc
 	BcacheOnlyForNotSSD bool
+
+	// readahead is disabled if ReadAheadMemMB is not positive
+	ReadAheadMemMB    int64
+	ReadAheadWindowMB int64
+
+	// max number of stream reads in flight on the connection to a data node,
+	// reads are not pipelined if ReadPipelineDepth is not positive
+	ReadPipelineDepth int
+
+	// follower reads slower than this percentile of the recent reads are
+	// sent to another replica as well, hedging is disabled if it's 0
+	HedgeReadPercentile int
 }
 
 type MultiVerMgr struct {
@@ -191,6 +203,12 @@ type ExtentClient struct {
 	getInodeInfo              GetInodeInfoFunc
 	bcacheOnlyForNotSSD       bool
 	InnerReq                  bool
+
+	readAheadMemLimit  int64
+	readAheadMemUsed   int64
+	readAheadMaxWindow int
+	readPipelines      *readPipelinePool
+	hedgeRead          *hedgeReadPolicy
 }
 
 func (client *ExtentClient) UidIsLimited(uid uint32) bool {
@@ -323,6 +341,21 @@ retry:
 	client.CacheDpStorageClass = config.VolCacheDpStorageClass
 	client.forbiddenMigration = config.OnForbiddenMigration
 	client.getInodeInfo = config.OnGetInodeInfo
+	if config.ReadAheadMemMB > 0 {
+		client.readAheadMemLimit = config.ReadAheadMemMB * util.MB
+		client.readAheadMaxWindow = defReadAheadWindowSize
+		if config.ReadAheadWindowMB > 0 {
+			client.readAheadMaxWindow = util.Max(int(config.ReadAheadWindowMB*util.MB), minReadAheadWindowSize)
+		}
+		log.LogInfof("readahead enabled, mem limit %d MB, max window %d MB", config.ReadAheadMemMB, client.readAheadMaxWindow/util.MB)
+	}
+	if config.ReadPipelineDepth > 0 {
+		client.readPipelines = newReadPipelinePool(config.ReadPipelineDepth)
+		log.LogInfof("read pipeline enabled, depth %d", config.ReadPipelineDepth)
+	}
+	if client.hedgeRead = newHedgeReadPolicy(client.volumeName, config.HedgeReadPercentile); client.hedgeRead != nil {
+		log.LogInfof("hedged read enabled, percentile %d", client.hedgeRead.percentile)
+	}
 
 	if config.StreamRetryTimeout <= 0 || config.StreamRetryTimeout >= 600 {
 		client.streamRetryTimeout = StreamSendMaxTimeout
@@ -738,7 +771,11 @@ func (client *ExtentClient) Read(inode uint64, data []byte, offset int, size int
 		}
 	}
 
-	read, err = s.read(data, offset, size, storageClass)
+	if s.readAhead != nil {
+		read, err = s.readAhead.read(data, offset, size, storageClass)
+	} else {
+		read, err = s.read(data, offset, size, storageClass)
+	}
 	// log.LogErrorf("======> ExtentClient Read Exit, inode(%v), time[%v us].", inode, time.Since(t1).Microseconds())
 	return
 }
@@ -37,6 +37,8 @@ type ExtentReader struct {
 	retryRead    bool
 
 	maxRetryTimeout time.Duration
+	pipelines       *readPipelinePool // nil if read pipelining is disabled
+	hedge           *hedgeReadPolicy  // nil if hedged reads are disabled
 }
 
 // NewExtentReader returns a new extent reader.
@@ -66,10 +68,37 @@ func (reader *ExtentReader) Read(req *ExtentRequest) (readBytes int, err error)
 
 	log.LogDebugf("ExtentReader Read enter: size(%v) req(%v) reqPacket(%v)", size, req, reqPacket)
 
+	if reader.hedge != nil {
+		start := time.Now()
+		defer func() {
+			if err == nil {
+				reader.hedge.record(time.Since(start))
+			}
+		}()
+		// only follower reads can be served by any replica
+		if reader.followerRead && len(reader.dp.Hosts) > 1 && reader.hedge.delay() > 0 {
+			if readBytes, err = reader.hedgedRead(sc.currAddr, reqPacket, req); err == nil {
+				log.LogDebugf("ExtentReader Read exit: hedged, req(%v) reqPacket(%v) readBytes(%v)", req, reqPacket, readBytes)
+				return
+			}
+			log.LogDebugf("ExtentReader Read: hedged read failed, fall back to stream conn, reqPacket(%v) err(%v)", reqPacket, err)
+		}
+	}
+
+	if reader.pipelines != nil && err == nil {
+		if readBytes, err = reader.readByPipeline(sc.currAddr, reqPacket, req); err == nil {
+			log.LogDebugf("ExtentReader Read exit: pipelined, addr(%v) req(%v) reqPacket(%v) readBytes(%v)", sc.currAddr, req, reqPacket, readBytes)
+			return
+		}
+		log.LogDebugf("ExtentReader Read: pipelined read failed, fall back to stream conn, addr(%v) reqPacket(%v) err(%v)", sc.currAddr, reqPacket, err)
+	}
+
 	err = sc.Send(&reader.retryRead, reqPacket, func(conn *net.TCPConn) (error, bool) {
 		readBytes = 0
+		// every field of the reply is overwritten by readFromConn, so one
+		// packet serves all the replies of the request
+		replyPacket := NewReply(reqPacket.ReqID, reader.dp.PartitionID, reqPacket.ExtentID)
 		for readBytes < size {
-			replyPacket := NewReply(reqPacket.ReqID, reader.dp.PartitionID, reqPacket.ExtentID)
 			bufSize := util.Min(util.ReadBlockSize, size-readBytes)
 			replyPacket.Data = req.Data[readBytes : readBytes+bufSize]
 			e := replyPacket.readFromConn(conn, proto.ReadDeadlineTime)
@@ -115,6 +144,14 @@ func (reader *ExtentReader) Read(req *ExtentRequest) (readBytes int, err error)
 	return
 }
 
+func (reader *ExtentReader) readByPipeline(addr string, reqPacket *Packet, req *ExtentRequest) (readBytes int, err error) {
+	rp, err := reader.pipelines.get(addr)
+	if err != nil {
+		return
+	}
+	return rp.read(reader, reqPacket, req)
+}
+
 func (reader *ExtentReader) checkStreamReply(request *Packet, reply *Packet) (err error) {
 	if reply.ResultCode == proto.OpTryOtherAddr {
 		return TryOtherAddrError
@@ -193,20 +193,23 @@ func (p *Packet) writeToConn(conn net.Conn) error {
 	return p.WriteToConn(conn)
 }
 
+// readFromConn reads a reply from the connection. The payload is read
+// straight into p.Data, and the optional version fields are read in one go
+// into the header buffer, so a reply costs no allocation and no copy.
 func (p *Packet) readFromConn(c net.Conn, deadlineTime time.Duration) (err error) {
 	if deadlineTime != proto.NoReadDeadlineTime {
 		c.SetReadDeadline(time.Now().Add(deadlineTime * time.Second))
 	}
-	header, _ := proto.Buffers.Get(util.PacketHeaderSize)
+	header, _ := proto.Buffers.Get(util.PacketHeaderProtoVerSize)
 	defer proto.Buffers.Put(header)
-	if _, err = io.ReadFull(c, header); err != nil {
+	if _, err = io.ReadFull(c, header[:util.PacketHeaderSize]); err != nil {
 		return
 	}
 	if err = p.UnmarshalHeader(header); err != nil {
 		return
 	}
 
-	if err = p.TryReadExtraFieldsFromConn(c); err != nil {
+	if err = p.readExtraFields(c, header[util.PacketHeaderSize:]); err != nil {
 		return
 	}
 
@@ -225,6 +228,26 @@ func (p *Packet) readFromConn(c net.Conn, deadlineTime time.Duration) (err error
 	return
 }
 
+// readExtraFields is proto.Packet.TryReadExtraFieldsFromConn without the
+// allocations, buf must hold the largest extra fields.
+func (p *Packet) readExtraFields(c net.Conn, buf []byte) (err error) {
+	if p.ExtentType&proto.PacketProtocolVersionFlag > 0 {
+		buf = buf[:util.PacketHeaderProtoVerSize-util.PacketHeaderSize]
+		if _, err = io.ReadFull(c, buf); err != nil {
+			return
+		}
+		p.VerSeq = binary.BigEndian.Uint64(buf[0:8])
+		p.ProtoVersion = binary.BigEndian.Uint32(buf[8:12])
+	} else if p.ExtentType&proto.MultiVersionFlag > 0 {
+		buf = buf[:util.PacketHeaderVerSize-util.PacketHeaderSize]
+		if _, err = io.ReadFull(c, buf); err != nil {
+			return
+		}
+		p.VerSeq = binary.BigEndian.Uint64(buf)
+	}
+	return
+}
+
 func readToBuffer(c net.Conn, buf *[]byte, readSize int) (err error) {
 	if *buf == nil || readSize != util.BlockSize {
 		*buf = make([]byte, readSize)
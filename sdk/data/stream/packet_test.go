@@ -0,0 +1,110 @@
+// Copyright 2024 The CubeFS Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+
+package stream
+
+import (
+	"hash/crc32"
+	"net"
+	"sync"
+	"testing"
+
+	"github.com/cubefs/cubefs/proto"
+	"github.com/cubefs/cubefs/util"
+	"github.com/stretchr/testify/require"
+)
+
+const benchReadSize = util.MB
+
+var initBufferPoolOnce sync.Once
+
+// readReplyConn returns a connection on which an endless stream of read
+// replies of util.ReadBlockSize bytes arrives, as sent by a data node.
+func readReplyConn(tb testing.TB) net.Conn {
+	initBufferPoolOnce.Do(func() { proto.InitBufferPool(0) })
+	ln, err := net.Listen("tcp", "127.0.0.1:0")
+	require.NoError(tb, err)
+	go func() {
+		defer ln.Close()
+		conn, err := ln.Accept()
+		if err != nil {
+			return
+		}
+		defer conn.Close()
+		reply := NewReply(1, 1, 1)
+		reply.ExtentType |= proto.PacketProtocolVersionFlag
+		reply.Opcode = proto.OpStreamFollowerRead
+		reply.ResultCode = proto.OpOk
+		reply.Data = make([]byte, util.ReadBlockSize)
+		reply.Size = uint32(len(reply.Data))
+		reply.CRC = crc32.ChecksumIEEE(reply.Data)
+		for reply.WriteToConn(conn) == nil {
+		}
+	}()
+	conn, err := net.Dial("tcp", ln.Addr().String())
+	require.NoError(tb, err)
+	tb.Cleanup(func() { conn.Close() })
+	return conn
+}
+
+func TestReadFromConn(t *testing.T) {
+	conn := readReplyConn(t)
+	data := make([]byte, util.ReadBlockSize)
+	reply := NewReply(0, 0, 0)
+	for i := 0; i < 3; i++ {
+		reply.Data = data
+		require.NoError(t, reply.readFromConn(conn, proto.ReadDeadlineTime))
+		require.EqualValues(t, 1, reply.ReqID)
+		require.EqualValues(t, util.ReadBlockSize, reply.Size)
+		require.Equal(t, crc32.ChecksumIEEE(data), reply.CRC)
+	}
+}
+
+// BenchmarkReadReplyCopy reads each reply into a buffer of its own, and
+// copies the payload into the destination.
+func BenchmarkReadReplyCopy(b *testing.B) {
+	conn := readReplyConn(b)
+	dst := make([]byte, benchReadSize)
+	b.SetBytes(benchReadSize)
+	b.ReportAllocs()
+	b.ResetTimer()
+	for i := 0; i < b.N; i++ {
+		for off := 0; off < benchReadSize; off += util.ReadBlockSize {
+			reply := new(proto.Packet)
+			if err := reply.ReadFromConn(conn, proto.ReadDeadlineTime); err != nil {
+				b.Fatal(err)
+			}
+			copy(dst[off:], reply.Data[:reply.Size])
+		}
+	}
+}
+
+// BenchmarkReadReplyDirect reads the payload of each reply straight into the
+// destination, as ExtentReader does.
+func BenchmarkReadReplyDirect(b *testing.B) {
+	conn := readReplyConn(b)
+	dst := make([]byte, benchReadSize)
+	reply := NewReply(0, 0, 0)
+	b.SetBytes(benchReadSize)
+	b.ReportAllocs()
+	b.ResetTimer()
+	for i := 0; i < b.N; i++ {
+		for off := 0; off < benchReadSize; off += util.ReadBlockSize {
+			reply.Data = dst[off : off+util.ReadBlockSize]
+			if err := reply.readFromConn(conn, proto.ReadDeadlineTime); err != nil {
+				b.Fatal(err)
+			}
+		}
+	}
+}
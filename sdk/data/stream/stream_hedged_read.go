@@ -0,0 +1,258 @@
+// Copyright 2024 The CubeFS Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+
+package stream
+
+import (
+	"net"
+	"sort"
+	"sync"
+	"sync/atomic"
+	"time"
+
+	"github.com/cubefs/cubefs/proto"
+	"github.com/cubefs/cubefs/util"
+	"github.com/cubefs/cubefs/util/errors"
+	"github.com/cubefs/cubefs/util/exporter"
+	"github.com/cubefs/cubefs/util/log"
+)
+
+const (
+	hedgeReadSamples       = 1024
+	hedgeReadMinSamples    = 128
+	hedgeReadRefreshPeriod = 256 // recompute the threshold every 256 samples
+	hedgeReadMinDelay      = time.Millisecond
+)
+
+var HedgeReadCanceledError = errors.New("HedgeReadCanceledError")
+
+// hedgeReadPolicy decides when a stream read is slow enough to be sent to
+// another replica as well. The threshold is a percentile of the latencies
+// of the recent reads of the volume.
+type hedgeReadPolicy struct {
+	volume     string
+	percentile int
+
+	sync.Mutex
+	samples   []int64 // ring of the latencies in nanoseconds
+	next      int
+	count     int
+	threshold int64 // atomic, 0 until there are enough samples
+}
+
+// newHedgeReadPolicy returns nil if percentile doesn't enable hedged reads,
+// a percentile of 100 or more is taken as the 99th.
+func newHedgeReadPolicy(volume string, percentile int) *hedgeReadPolicy {
+	if percentile <= 0 {
+		return nil
+	}
+	if percentile >= 100 {
+		log.LogWarnf("newHedgeReadPolicy: percentile(%v) out of range, use 99", percentile)
+		percentile = 99
+	}
+	return &hedgeReadPolicy{
+		volume:     volume,
+		percentile: percentile,
+		samples:    make([]int64, hedgeReadSamples),
+	}
+}
+
+func (h *hedgeReadPolicy) record(latency time.Duration) {
+	h.Lock()
+	h.samples[h.next] = int64(latency)
+	h.next = (h.next + 1) % len(h.samples)
+	h.count++
+	if h.count < hedgeReadMinSamples || h.count%hedgeReadRefreshPeriod != 0 {
+		h.Unlock()
+		return
+	}
+	n := util.Min(h.count, len(h.samples))
+	sorted := make([]int64, n)
+	copy(sorted, h.samples[:n])
+	h.Unlock()
+
+	sort.Slice(sorted, func(i, j int) bool { return sorted[i] < sorted[j] })
+	threshold := sorted[(n-1)*h.percentile/100]
+	if threshold < int64(hedgeReadMinDelay) {
+		threshold = int64(hedgeReadMinDelay)
+	}
+	atomic.StoreInt64(&h.threshold, threshold)
+}
+
+func (h *hedgeReadPolicy) delay() time.Duration {
+	return time.Duration(atomic.LoadInt64(&h.threshold))
+}
+
+func (h *hedgeReadPolicy) metric(name string) {
+	exporter.NewCounter(name).AddWithLabels(1, map[string]string{exporter.Vol: h.volume})
+}
+
+// hedgedRead is a stream read to a single host, which can be canceled.
+type hedgedRead struct {
+	addr      string
+	packet    *Packet
+	data      []byte
+	readBytes int
+	err       error
+
+	sync.Mutex
+	conn     *net.TCPConn // nil unless the read is waiting for replies
+	canceled bool
+}
+
+func (hr *hedgedRead) cancel() {
+	hr.Lock()
+	defer hr.Unlock()
+	hr.canceled = true
+	if hr.conn != nil {
+		hr.conn.SetReadDeadline(time.Now())
+	}
+}
+
+func (hr *hedgedRead) run(reader *ExtentReader) {
+	conn, err := StreamConnPool.GetConnect(hr.addr)
+	if err != nil {
+		hr.err = err
+		return
+	}
+	hr.Lock()
+	if hr.canceled {
+		hr.Unlock()
+		StreamConnPool.PutConnect(conn, false)
+		hr.err = HedgeReadCanceledError
+		return
+	}
+	hr.conn = conn
+	hr.Unlock()
+
+	hr.packet.ExtentType |= proto.PacketProtocolVersionFlag
+	if hr.err = hr.packet.WriteToConn(conn); hr.err == nil {
+		hr.err = hr.receive(reader, conn)
+	}
+	// the connection is in an unknown state once canceled
+	hr.Lock()
+	hr.conn = nil
+	canceled := hr.canceled
+	hr.Unlock()
+	if hr.err != nil || canceled {
+		StreamConnPool.PutConnect(conn, true)
+		return
+	}
+	StreamConnPool.PutConnectV2(conn, false, hr.addr)
+}
+
+func (hr *hedgedRead) receive(reader *ExtentReader, conn *net.TCPConn) error {
+	size := int(hr.packet.Size)
+	for hr.readBytes < size {
+		reply := NewReply(hr.packet.ReqID, hr.packet.PartitionID, hr.packet.ExtentID)
+		bufSize := util.Min(util.ReadBlockSize, size-hr.readBytes)
+		reply.Data = hr.data[hr.readBytes : hr.readBytes+bufSize]
+		if err := reply.readFromConn(conn, proto.ReadDeadlineTime); err != nil {
+			return err
+		}
+		if err := reader.checkStreamReply(hr.packet, reply); err != nil {
+			return err
+		}
+		hr.readBytes += int(reply.Size)
+	}
+	return nil
+}
+
+// hedge is the read sent to another replica once the first one is slow.
+type hedge struct {
+	readBytes int
+	err       error
+	data      []byte // allocated once the hedge is sent
+	done      chan struct{}
+
+	sync.Mutex
+	read *hedgedRead // nil if sent on a read pipeline
+}
+
+func (h *hedge) cancel() {
+	h.Lock()
+	defer h.Unlock()
+	if h.read != nil {
+		h.read.cancel()
+	}
+}
+
+// run reads from addr, on its read pipeline if read pipelining is enabled,
+// and cancels primary once done.
+func (h *hedge) run(reader *ExtentReader, addr string, packet *Packet, req *ExtentRequest, primary *hedgedRead) {
+	defer close(h.done)
+	if reader.pipelines != nil {
+		if h.readBytes, h.err = reader.readByPipeline(addr, packet, req); h.err == nil {
+			primary.cancel()
+			return
+		}
+		// a new packet, the pipeline may still hold the old one
+		packet = NewReadPacket(reader.key, int(packet.ExtentOffset), req.Size, reader.inode, req.FileOffset, reader.followerRead)
+	}
+	hr := &hedgedRead{addr: addr, packet: packet, data: h.data}
+	h.Lock()
+	h.read = hr
+	h.Unlock()
+	hr.run(reader)
+	if h.readBytes, h.err = hr.readBytes, hr.err; h.err == nil {
+		primary.cancel()
+	}
+}
+
+// hedgedRead reads from the chosen host, and sends the same read to another
+// replica if no reply arrived within the hedge delay. The first complete
+// reply wins. The read from the chosen host runs in the caller's goroutine,
+// so a goroutine is only started for the hedges. It returns an error if the
+// read has to be done again through StreamConn, which handles the retries.
+func (reader *ExtentReader) hedgedRead(addr string, reqPacket *Packet, req *ExtentRequest) (readBytes int, err error) {
+	primary := &hedgedRead{addr: addr, packet: reqPacket, data: req.Data[:req.Size]}
+	h := &hedge{done: make(chan struct{})}
+	timer := time.AfterFunc(reader.hedge.delay(), func() {
+		var other string
+		for _, host := range sortByStatus(reader.dp, false) {
+			if host != addr {
+				other = host
+				break
+			}
+		}
+		if other == "" {
+			h.err = HedgeReadCanceledError
+			close(h.done)
+			return
+		}
+		reader.hedge.metric("hedgeReadFired")
+		log.LogDebugf("hedgedRead: ino(%v) req(%v) primary(%v) is slow, hedge to (%v)", reader.inode, req, addr, other)
+		// allocated only when a hedge is sent, which is rare
+		h.data = make([]byte, req.Size)
+		offset := int(reqPacket.ExtentOffset)
+		hedgePacket := NewReadPacket(reader.key, offset, req.Size, reader.inode, req.FileOffset, reader.followerRead)
+		h.run(reader, other, hedgePacket, &ExtentRequest{FileOffset: req.FileOffset, Size: req.Size, Data: h.data}, primary)
+	})
+
+	primary.run(reader)
+	if timer.Stop() {
+		return primary.readBytes, primary.err
+	}
+	if primary.err == nil {
+		h.cancel()
+		return primary.readBytes, nil
+	}
+	<-h.done
+	if h.err != nil {
+		return primary.readBytes, primary.err
+	}
+	reader.hedge.metric("hedgeReadWon")
+	copy(req.Data, h.data[:h.readBytes])
+	return h.readBytes, nil
+}
@@ -0,0 +1,120 @@
+// Copyright 2024 The CubeFS Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+
+package stream
+
+import (
+	"sync/atomic"
+	"testing"
+	"time"
+
+	"github.com/cubefs/cubefs/proto"
+	"github.com/cubefs/cubefs/sdk/data/wrapper"
+	"github.com/stretchr/testify/require"
+)
+
+func TestHedgeReadPolicy(t *testing.T) {
+	require.Nil(t, newHedgeReadPolicy("test", 0))
+	require.Equal(t, 99, newHedgeReadPolicy("test", 100).percentile)
+	require.Equal(t, 99, newHedgeReadPolicy("test", 150).percentile)
+
+	h := newHedgeReadPolicy("test", 90)
+	// no threshold until there are enough samples
+	for i := 1; i < hedgeReadRefreshPeriod; i++ {
+		h.record(time.Duration(i) * time.Millisecond)
+	}
+	require.Equal(t, time.Duration(0), h.delay())
+	h.record(hedgeReadRefreshPeriod * time.Millisecond)
+	require.Equal(t, 230*time.Millisecond, h.delay())
+
+	// the threshold is refreshed from the recent samples only, and is at
+	// least hedgeReadMinDelay
+	for i := 0; i < hedgeReadSamples; i++ {
+		h.record(time.Microsecond)
+	}
+	require.Equal(t, hedgeReadMinDelay, h.delay())
+
+	h = newHedgeReadPolicy("test", 100)
+	for i := 1; i <= hedgeReadRefreshPeriod; i++ {
+		h.record(time.Duration(i) * time.Millisecond)
+	}
+	require.Equal(t, 253*time.Millisecond, h.delay())
+}
+
+// newHedgedReader returns a follower reader of extent 7 of a partition on
+// the given data nodes, hedged after delay.
+func newHedgedReader(delay time.Duration, dns ...*fakeDataNode) *ExtentReader {
+	dp := &wrapper.DataPartition{ClientWrapper: &wrapper.Wrapper{HostsStatus: make(map[string]bool)}}
+	dp.PartitionID = 1
+	for _, dn := range dns {
+		dp.Hosts = append(dp.Hosts, dn.addr())
+		dp.ClientWrapper.HostsStatus[dn.addr()] = true
+	}
+	reader := NewExtentReader(1, &proto.ExtentKey{PartitionId: 1, ExtentId: 7}, dp, true, false)
+	reader.hedge = newHedgeReadPolicy("test", 90)
+	atomic.StoreInt64(&reader.hedge.threshold, int64(delay))
+	return reader
+}
+
+func testHedgedRead(t *testing.T, reader *ExtentReader, addr string, size int) {
+	packet, req := newTestReadPacket(7, 4096, size)
+	n, err := reader.hedgedRead(addr, packet, req)
+	require.NoError(t, err)
+	require.Equal(t, size, n)
+	checkExtentData(t, 7, 4096, req.Data)
+}
+
+func TestHedgedRead(t *testing.T) {
+	slow, fast := newFakeDataNode(t, false), newFakeDataNode(t, false)
+	atomic.StoreInt64(&slow.delay, int64(time.Second))
+	reader := newHedgedReader(10*time.Millisecond, slow, fast)
+
+	// a fast read isn't hedged
+	testHedgedRead(t, reader, fast.addr(), 300<<10)
+	require.EqualValues(t, 0, atomic.LoadInt64(&slow.reads))
+
+	// a slow one is served by the other replica
+	start := time.Now()
+	testHedgedRead(t, reader, slow.addr(), 300<<10)
+	require.Less(t, time.Since(start), time.Second)
+	require.EqualValues(t, 2, atomic.LoadInt64(&fast.reads))
+
+	// and the hedge is sent on the read pipeline of the replica
+	reader.pipelines = &readPipelinePool{depth: 4, pipelines: make(map[string]*readPipeline)}
+	for i := 0; i < 2; i++ {
+		testHedgedRead(t, reader, slow.addr(), 64<<10)
+	}
+	require.Len(t, reader.pipelines.pipelines, 1)
+	rp := reader.pipelines.pipelines[fast.addr()]
+	require.NotNil(t, rp)
+	rp.close()
+	require.EqualValues(t, 4, atomic.LoadInt64(&fast.reads))
+}
+
+func TestHedgedReadError(t *testing.T) {
+	slow, failing := newFakeDataNode(t, false), newFakeDataNode(t, false)
+	atomic.StoreInt64(&slow.delay, int64(100*time.Millisecond))
+	atomic.StoreUint64(&failing.failExtent, 7)
+	reader := newHedgedReader(10*time.Millisecond, slow, failing)
+
+	// the primary read is kept if the hedge fails
+	testHedgedRead(t, reader, slow.addr(), 64<<10)
+	require.EqualValues(t, 1, atomic.LoadInt64(&failing.reads))
+
+	// and the error of the primary one is returned if no hedge can be sent
+	reader = newHedgedReader(10*time.Millisecond, failing)
+	packet, req := newTestReadPacket(7, 0, 4096)
+	_, err := reader.hedgedRead(failing.addr(), packet, req)
+	require.Error(t, err)
+}
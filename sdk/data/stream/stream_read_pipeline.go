@@ -0,0 +1,224 @@
+// Copyright 2024 The CubeFS Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+
+package stream
+
+import (
+	"net"
+	"sync"
+	"sync/atomic"
+	"time"
+
+	"github.com/cubefs/cubefs/proto"
+	"github.com/cubefs/cubefs/util"
+	"github.com/cubefs/cubefs/util/errors"
+	"github.com/cubefs/cubefs/util/log"
+)
+
+const readPipelineIdleTimeout = 30 * time.Second
+
+var ReadPipelineBrokenError = errors.New("ReadPipelineBrokenError")
+
+// pipelineRead is a stream read waiting for its replies on a read pipeline.
+type pipelineRead struct {
+	reader    *ExtentReader
+	packet    *Packet
+	req       *ExtentRequest
+	readBytes int
+	err       error
+	done      chan struct{}
+}
+
+// readPipeline multiplexes the stream reads to one data node over a single
+// connection. The data node handles the packets of a connection in order,
+// so the replies are matched with the requests in the order they were sent,
+// and several reads can be in flight without waiting for a full round trip
+// each, like ExtentHandler.sender/receiver do for writes.
+//
+// Any failure breaks the pipeline, all the reads in flight then fail with
+// ReadPipelineBrokenError and are retried by the caller through StreamConn.
+type readPipeline struct {
+	addr    string
+	conn    *net.TCPConn
+	pending chan *pipelineRead
+	broken  int32
+
+	sync.Mutex // serializes the sends, so the order of pending is the order on the wire
+	closed     bool
+	inflight   int
+	lastActive time.Time
+}
+
+func newReadPipeline(addr string, depth int) (rp *readPipeline, err error) {
+	conn, err := StreamConnPool.GetConnect(addr)
+	if err != nil {
+		return
+	}
+	rp = &readPipeline{
+		addr:       addr,
+		conn:       conn,
+		pending:    make(chan *pipelineRead, depth),
+		lastActive: time.Now(),
+	}
+	go rp.receiver()
+	return
+}
+
+func (rp *readPipeline) read(reader *ExtentReader, packet *Packet, req *ExtentRequest) (readBytes int, err error) {
+	pr := &pipelineRead{
+		reader: reader,
+		packet: packet,
+		req:    req,
+		done:   make(chan struct{}),
+	}
+	packet.ExtentType |= proto.PacketProtocolVersionFlag
+
+	rp.Lock()
+	if rp.closed || rp.isBroken() {
+		rp.Unlock()
+		return 0, ReadPipelineBrokenError
+	}
+	rp.inflight++
+	rp.lastActive = time.Now()
+	rp.pending <- pr
+	if err = packet.WriteToConn(rp.conn); err != nil {
+		log.LogWarnf("readPipeline: failed to write to addr(%v) packet(%v) err(%v)", rp.addr, packet, err)
+		// the receiver fails the read once the connection is closed
+		rp.conn.Close()
+	}
+	rp.Unlock()
+
+	<-pr.done
+
+	rp.Lock()
+	rp.inflight--
+	rp.Unlock()
+	return pr.readBytes, pr.err
+}
+
+func (rp *readPipeline) receiver() {
+	for pr := range rp.pending {
+		if rp.isBroken() {
+			pr.err = ReadPipelineBrokenError
+		} else if err := rp.receive(pr); err != nil {
+			atomic.StoreInt32(&rp.broken, 1)
+			rp.conn.Close()
+			pr.err = err
+		}
+		close(pr.done)
+	}
+}
+
+func (rp *readPipeline) receive(pr *pipelineRead) (err error) {
+	size := pr.req.Size
+	for pr.readBytes < size {
+		reply := NewReply(pr.packet.ReqID, pr.packet.PartitionID, pr.packet.ExtentID)
+		bufSize := util.Min(util.ReadBlockSize, size-pr.readBytes)
+		reply.Data = pr.req.Data[pr.readBytes : pr.readBytes+bufSize]
+		if err = reply.readFromConn(rp.conn, proto.ReadDeadlineTime); err != nil {
+			log.LogWarnf("readPipeline: failed to read from addr(%v) packet(%v) err(%v)", rp.addr, pr.packet, err)
+			return ReadPipelineBrokenError
+		}
+		// the data node closes the connection after a failed read, leave
+		// the retries to the caller
+		if reply.ResultCode != proto.OpOk {
+			log.LogWarnf("readPipeline: addr(%v) packet(%v) reply(%v)", rp.addr, pr.packet, reply.GetResultMsg())
+			return ReadPipelineBrokenError
+		}
+		if err = pr.reader.checkStreamReply(pr.packet, reply); err != nil {
+			log.LogWarnf("readPipeline: addr(%v) checkStreamReply failed:(%v)", rp.addr, err)
+			return ReadPipelineBrokenError
+		}
+		pr.readBytes += int(reply.Size)
+	}
+	return nil
+}
+
+func (rp *readPipeline) isBroken() bool {
+	return atomic.LoadInt32(&rp.broken) == 1
+}
+
+func (rp *readPipeline) idle() bool {
+	rp.Lock()
+	defer rp.Unlock()
+	return rp.inflight == 0 && time.Since(rp.lastActive) > readPipelineIdleTimeout
+}
+
+// close stops the receiver and releases the connection, the reads still
+// queued are failed by the receiver.
+func (rp *readPipeline) close() {
+	rp.Lock()
+	defer rp.Unlock()
+	if rp.closed {
+		return
+	}
+	rp.closed = true
+	close(rp.pending)
+	rp.conn.Close()
+}
+
+// readPipelinePool keeps one read pipeline per data node.
+type readPipelinePool struct {
+	sync.RWMutex
+	depth     int
+	pipelines map[string]*readPipeline
+}
+
+func newReadPipelinePool(depth int) *readPipelinePool {
+	pool := &readPipelinePool{
+		depth:     depth,
+		pipelines: make(map[string]*readPipeline),
+	}
+	go pool.autoRelease()
+	return pool
+}
+
+func (pool *readPipelinePool) get(addr string) (rp *readPipeline, err error) {
+	pool.RLock()
+	rp = pool.pipelines[addr]
+	pool.RUnlock()
+	if rp != nil && !rp.isBroken() {
+		return
+	}
+
+	pool.Lock()
+	defer pool.Unlock()
+	if rp = pool.pipelines[addr]; rp != nil {
+		if !rp.isBroken() {
+			return
+		}
+		rp.close()
+		delete(pool.pipelines, addr)
+	}
+	if rp, err = newReadPipeline(addr, pool.depth); err != nil {
+		return
+	}
+	pool.pipelines[addr] = rp
+	return
+}
+
+func (pool *readPipelinePool) autoRelease() {
+	t := time.NewTicker(readPipelineIdleTimeout)
+	defer t.Stop()
+	for range t.C {
+		pool.Lock()
+		for addr, rp := range pool.pipelines {
+			if rp.isBroken() || rp.idle() {
+				delete(pool.pipelines, addr)
+				rp.close()
+			}
+		}
+		pool.Unlock()
+	}
+}
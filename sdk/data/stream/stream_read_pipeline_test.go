@@ -0,0 +1,214 @@
+// Copyright 2024 The CubeFS Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+
+package stream
+
+import (
+	"hash/crc32"
+	"net"
+	"sync"
+	"sync/atomic"
+	"testing"
+	"time"
+
+	"github.com/cubefs/cubefs/proto"
+	"github.com/cubefs/cubefs/util"
+	"github.com/stretchr/testify/require"
+)
+
+// extentByte is the content of the extents served by fakeDataNode.
+func extentByte(extentID uint64, offset int) byte {
+	return byte((extentID + uint64(offset)) % 251)
+}
+
+// fakeDataNode serves the stream reads of any extent, in the order they
+// arrive on a connection, in replies of util.ReadBlockSize bytes like a data
+// node. The reads of failExtent are answered with an error, after which the
+// connection is closed, and the replies are sent after delay. The
+// connections are served once hold is closed.
+type fakeDataNode struct {
+	ln         net.Listener
+	hold       chan struct{}
+	failExtent uint64 // atomic
+	delay      int64  // atomic, nanoseconds
+	reads      int64  // atomic
+}
+
+// newFakeDataNode returns a data node serving the connections at once, or
+// once hold is closed if held is set.
+func newFakeDataNode(t testing.TB, held bool) *fakeDataNode {
+	initBufferPoolOnce.Do(func() { proto.InitBufferPool(0) })
+	ln, err := net.Listen("tcp", "127.0.0.1:0")
+	require.NoError(t, err)
+	dn := &fakeDataNode{ln: ln, hold: make(chan struct{})}
+	if !held {
+		close(dn.hold)
+	}
+	go func() {
+		for {
+			conn, err := ln.Accept()
+			if err != nil {
+				return
+			}
+			go dn.serve(conn)
+		}
+	}()
+	t.Cleanup(func() { ln.Close() })
+	return dn
+}
+
+func (dn *fakeDataNode) addr() string {
+	return dn.ln.Addr().String()
+}
+
+func (dn *fakeDataNode) serve(conn net.Conn) {
+	defer conn.Close()
+	<-dn.hold
+	for {
+		p := proto.NewPacket()
+		if err := p.ReadFromConnWithVer(conn, proto.NoReadDeadlineTime); err != nil {
+			return
+		}
+		atomic.AddInt64(&dn.reads, 1)
+		if delay := atomic.LoadInt64(&dn.delay); delay > 0 {
+			time.Sleep(time.Duration(delay))
+		}
+		if p.ExtentID == atomic.LoadUint64(&dn.failExtent) {
+			p.PacketErrorWithBody(proto.OpErr, []byte("read failed"))
+			p.WriteToConn(conn)
+			return
+		}
+		for done := 0; done < int(p.Size); {
+			reply := NewReply(p.ReqID, p.PartitionID, p.ExtentID)
+			reply.ExtentType |= proto.PacketProtocolVersionFlag
+			reply.Opcode = p.Opcode
+			reply.ResultCode = proto.OpOk
+			reply.Data = make([]byte, util.Min(util.ReadBlockSize, int(p.Size)-done))
+			for i := range reply.Data {
+				reply.Data[i] = extentByte(p.ExtentID, int(p.ExtentOffset)+done+i)
+			}
+			reply.Size = uint32(len(reply.Data))
+			reply.CRC = crc32.ChecksumIEEE(reply.Data)
+			if err := reply.WriteToConn(conn); err != nil {
+				return
+			}
+			done += len(reply.Data)
+		}
+	}
+}
+
+func newTestReadPacket(extentID uint64, offset, size int) (*Packet, *ExtentRequest) {
+	key := &proto.ExtentKey{PartitionId: 1, ExtentId: extentID}
+	return NewReadPacket(key, offset, size, 1, offset, true), &ExtentRequest{Size: size, Data: make([]byte, size)}
+}
+
+func checkExtentData(t *testing.T, extentID uint64, offset int, data []byte) {
+	for i, c := range data {
+		if c != extentByte(extentID, offset+i) {
+			require.Failf(t, "bad data", "extent(%v) offset(%v)", extentID, offset+i)
+		}
+	}
+}
+
+func TestReadPipeline(t *testing.T) {
+	dn := newFakeDataNode(t, false)
+	rp, err := newReadPipeline(dn.addr(), 4)
+	require.NoError(t, err)
+	defer rp.close()
+
+	const (
+		readers = 16
+		reads   = 16
+	)
+	reader := &ExtentReader{}
+	var wg sync.WaitGroup
+	for i := 0; i < readers; i++ {
+		wg.Add(1)
+		go func(i int) {
+			defer wg.Done()
+			for j := 0; j < reads; j++ {
+				// from less than a reply to several ones
+				size := 1 + (i*reads+j)*4099%(3*util.ReadBlockSize)
+				offset := j * 1000
+				extentID := uint64(i + 1)
+				packet, req := newTestReadPacket(extentID, offset, size)
+				n, err := rp.read(reader, packet, req)
+				require.NoError(t, err)
+				require.Equal(t, size, n)
+				checkExtentData(t, extentID, offset, req.Data)
+			}
+		}(i)
+	}
+	wg.Wait()
+	require.False(t, rp.isBroken())
+	require.EqualValues(t, readers*reads, atomic.LoadInt64(&dn.reads))
+	rp.Lock()
+	require.Equal(t, 0, rp.inflight)
+	rp.Unlock()
+}
+
+func TestReadPipelineBroken(t *testing.T) {
+	dn := newFakeDataNode(t, true)
+	atomic.StoreUint64(&dn.failExtent, 1)
+	pool := &readPipelinePool{depth: 8, pipelines: make(map[string]*readPipeline)}
+	rp, err := pool.get(dn.addr())
+	require.NoError(t, err)
+
+	// the failed read and the ones behind it fail with the pipeline, the
+	// ones before it succeed
+	reader := &ExtentReader{}
+	errs := make([]error, 6)
+	var wg sync.WaitGroup
+	for i := range errs {
+		packet, req := newTestReadPacket(uint64(i+10), 0, 4096)
+		if i == 2 {
+			packet, req = newTestReadPacket(1, 0, 4096)
+		}
+		wg.Add(1)
+		go func(i int) {
+			defer wg.Done()
+			_, errs[i] = rp.read(reader, packet, req)
+		}(i)
+		// queue the reads in order
+		for {
+			rp.Lock()
+			inflight := rp.inflight
+			rp.Unlock()
+			if inflight == i+1 {
+				break
+			}
+			time.Sleep(time.Millisecond)
+		}
+	}
+	close(dn.hold)
+	wg.Wait()
+	require.NoError(t, errs[0])
+	require.NoError(t, errs[1])
+	for _, err := range errs[2:] {
+		require.Equal(t, ReadPipelineBrokenError, err)
+	}
+	require.True(t, rp.isBroken())
+
+	// the reads on a broken pipeline fail at once, and the pool replaces it
+	packet, req := newTestReadPacket(2, 0, 4096)
+	_, err = rp.read(reader, packet, req)
+	require.Equal(t, ReadPipelineBrokenError, err)
+	rp2, err := pool.get(dn.addr())
+	require.NoError(t, err)
+	require.NotEqual(t, rp, rp2)
+	defer rp2.close()
+	_, err = rp2.read(reader, packet, req)
+	require.NoError(t, err)
+	checkExtentData(t, 2, 0, req.Data)
+}
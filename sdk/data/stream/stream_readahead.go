@@ -0,0 +1,212 @@
+// Copyright 2024 The CubeFS Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+
+package stream
+
+import (
+	"io"
+	"sync"
+	"sync/atomic"
+
+	"github.com/cubefs/cubefs/util"
+	"github.com/cubefs/cubefs/util/exporter"
+	"github.com/cubefs/cubefs/util/log"
+)
+
+const (
+	readAheadBlockSize     = util.MB
+	minReadAheadWindowSize = 2 * readAheadBlockSize
+	defReadAheadWindowSize = 16 * readAheadBlockSize
+)
+
+var readAheadBlockPool = &sync.Pool{New: func() interface{} {
+	return make([]byte, readAheadBlockSize)
+}}
+
+// readAheadBlock caches a block aligned range of the file. The block is
+// referenced by the readahead map, the loader and every reader copying from
+// it, and its buffer goes back to the pool when the last reference is dropped.
+type readAheadBlock struct {
+	offset int
+	data   []byte
+	size   int // valid bytes, less than the block size at the end of file
+	gen    uint64
+	err    error
+	ready  chan struct{}
+	refs   int32
+}
+
+func (b *readAheadBlock) put(client *ExtentClient) {
+	if atomic.AddInt32(&b.refs, -1) == 0 {
+		readAheadBlockPool.Put(b.data)
+		b.data = nil
+		atomic.AddInt64(&client.readAheadMemUsed, -readAheadBlockSize)
+	}
+}
+
+// readAhead detects sequential reads of a streamer, and prefetches the
+// following ranges of the file in the background. The window doubles on
+// every sequential read up to the configured maximum, and is reset by
+// random reads.
+type readAhead struct {
+	sync.Mutex
+	s          *Streamer
+	blocks     map[int]*readAheadBlock // keyed by block aligned file offset
+	nextOffset int                     // where the last read ended
+	window     int
+
+	// readFile reads the file bypassing the readahead, Streamer.read
+	readFile func(data []byte, offset int, size int, storageClass uint32) (int, error)
+}
+
+func newReadAhead(s *Streamer) *readAhead {
+	return &readAhead{
+		s:        s,
+		blocks:   make(map[int]*readAheadBlock),
+		readFile: s.read,
+	}
+}
+
+func (ra *readAhead) read(data []byte, offset int, size int, storageClass uint32) (total int, err error) {
+	client := ra.s.client
+	filesize, gen := ra.s.extents.Size()
+
+	ra.Lock()
+	if offset == ra.nextOffset {
+		if ra.window == 0 {
+			ra.window = minReadAheadWindowSize
+		} else if ra.window < client.readAheadMaxWindow {
+			ra.window = util.Min(ra.window*2, client.readAheadMaxWindow)
+		}
+	} else {
+		ra.window = 0
+	}
+	ra.nextOffset = offset + size
+
+	// drop the blocks behind a sequential reader, and the ones out of
+	// reach after a random read
+	for blkOff, b := range ra.blocks {
+		if blkOff+readAheadBlockSize <= offset || blkOff >= offset+size+client.readAheadMaxWindow || b.gen != gen {
+			delete(ra.blocks, blkOff)
+			b.put(client)
+		}
+	}
+
+	var hits []*readAheadBlock
+	for blkOff := offset / readAheadBlockSize * readAheadBlockSize; blkOff < offset+size; blkOff += readAheadBlockSize {
+		b, ok := ra.blocks[blkOff]
+		if !ok {
+			break
+		}
+		atomic.AddInt32(&b.refs, 1)
+		hits = append(hits, b)
+	}
+
+	if ra.window > 0 {
+		ra.prefetch(offset+size, filesize, gen, storageClass)
+	}
+	ra.Unlock()
+
+	pos := offset
+	stop, eof := false, false
+	for _, b := range hits {
+		if !stop {
+			<-b.ready
+			if b.err != nil || pos < b.offset || pos > b.offset+b.size {
+				stop = true
+			} else {
+				pos += copy(data[pos-offset:size], b.data[pos-b.offset:b.size])
+				// a partial block means the file ends in it
+				if b.size < readAheadBlockSize {
+					eof = true
+					stop = true
+				}
+			}
+		}
+		b.put(client)
+	}
+
+	total = pos - offset
+	if total > 0 {
+		exporter.NewCounter("fileReadAheadHit").AddWithLabels(1, map[string]string{exporter.Vol: client.volumeName})
+	}
+	if eof {
+		if total < size {
+			err = io.EOF
+		}
+		return
+	}
+	if total == size {
+		return
+	}
+
+	exporter.NewCounter("fileReadAheadMiss").AddWithLabels(1, map[string]string{exporter.Vol: client.volumeName})
+	n, err := ra.readFile(data[total:size], pos, size-total, storageClass)
+	total += n
+	return
+}
+
+// prefetch loads the blocks in [from, from+window) which are not cached yet.
+// It must be called with the lock held.
+func (ra *readAhead) prefetch(from int, filesize int, gen uint64, storageClass uint32) {
+	client := ra.s.client
+	end := util.Min(from+ra.window, filesize)
+	for blkOff := from / readAheadBlockSize * readAheadBlockSize; blkOff < end; blkOff += readAheadBlockSize {
+		if _, ok := ra.blocks[blkOff]; ok {
+			continue
+		}
+		if atomic.AddInt64(&client.readAheadMemUsed, readAheadBlockSize) > client.readAheadMemLimit {
+			atomic.AddInt64(&client.readAheadMemUsed, -readAheadBlockSize)
+			log.LogDebugf("readahead: ino(%v) memory limit reached, offset(%v)", ra.s.inode, blkOff)
+			break
+		}
+		b := &readAheadBlock{
+			offset: blkOff,
+			data:   readAheadBlockPool.Get().([]byte),
+			gen:    gen,
+			ready:  make(chan struct{}),
+			refs:   2, // one for the map, one for the loader
+		}
+		ra.blocks[blkOff] = b
+		go ra.load(b, storageClass)
+	}
+}
+
+func (ra *readAhead) load(b *readAheadBlock, storageClass uint32) {
+	n, err := ra.readFile(b.data, b.offset, readAheadBlockSize, storageClass)
+	if err == io.EOF {
+		err = nil
+	}
+	if err != nil {
+		log.LogWarnf("readahead: ino(%v) offset(%v) read(%v) err(%v)", ra.s.inode, b.offset, n, err)
+	}
+	b.size = n
+	b.err = err
+	close(b.ready)
+	b.put(ra.s.client)
+}
+
+// invalidate drops all the cached blocks, it's called once the file is
+// modified through the streamer. A block loaded while the modification was
+// in progress may hold the data from before it, and the extents generation
+// does not change on overwrites, so the blocks can't be dropped earlier.
+func (ra *readAhead) invalidate() {
+	ra.Lock()
+	defer ra.Unlock()
+	for blkOff, b := range ra.blocks {
+		delete(ra.blocks, blkOff)
+		b.put(ra.s.client)
+	}
+	ra.window = 0
+}
@@ -0,0 +1,238 @@
+// Copyright 2024 The CubeFS Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+
+package stream
+
+import (
+	"bytes"
+	"io"
+	"sync"
+	"sync/atomic"
+	"testing"
+
+	"github.com/cubefs/cubefs/proto"
+	"github.com/stretchr/testify/require"
+)
+
+// readAheadFile is the content of the file read by a test streamer, which
+// stands for the data nodes.
+type readAheadFile struct {
+	sync.RWMutex
+	data   []byte
+	loads  int64 // block reads, issued by the readahead loader
+	misses int64 // other reads
+}
+
+func (f *readAheadFile) read(data []byte, offset int, size int, storageClass uint32) (int, error) {
+	if size == readAheadBlockSize && offset%readAheadBlockSize == 0 {
+		atomic.AddInt64(&f.loads, 1)
+	} else {
+		atomic.AddInt64(&f.misses, 1)
+	}
+	f.RLock()
+	defer f.RUnlock()
+	if offset >= len(f.data) {
+		return 0, io.EOF
+	}
+	n := copy(data[:size], f.data[offset:])
+	if n < size {
+		return n, io.EOF
+	}
+	return n, nil
+}
+
+func (f *readAheadFile) fill(c byte) {
+	f.Lock()
+	defer f.Unlock()
+	for i := range f.data {
+		f.data[i] = c
+	}
+}
+
+func newReadAheadStreamer(size int, maxWindow int) (*Streamer, *readAheadFile) {
+	f := &readAheadFile{data: make([]byte, size)}
+	client := &ExtentClient{
+		volumeName:         "readahead",
+		readAheadMemLimit:  int64(4 * maxWindow),
+		readAheadMaxWindow: maxWindow,
+		getExtents: func(inode uint64, isCache bool, openForWrite bool, isMigration bool) (uint64, uint64, []proto.ExtentKey, error) {
+			// an overwrite leaves the generation unchanged
+			return 1, uint64(size), nil, nil
+		},
+		truncate: func(inode, size uint64, fullPath string) error {
+			return nil
+		},
+	}
+	s := &Streamer{
+		client:    client,
+		inode:     1,
+		extents:   NewExtentCache(1),
+		dirtylist: NewDirtyExtentList(),
+	}
+	s.extents.SetSize(uint64(size), true)
+	s.readAhead = newReadAhead(s)
+	s.readAhead.readFile = f.read
+	return s, f
+}
+
+// waitReadAhead waits for the loads in progress.
+func waitReadAhead(ra *readAhead) {
+	ra.Lock()
+	blocks := make([]*readAheadBlock, 0, len(ra.blocks))
+	for _, b := range ra.blocks {
+		blocks = append(blocks, b)
+	}
+	ra.Unlock()
+	for _, b := range blocks {
+		<-b.ready
+	}
+}
+
+func TestReadAheadWindow(t *testing.T) {
+	const maxWindow = 8 * readAheadBlockSize
+	s, _ := newReadAheadStreamer(64*readAheadBlockSize, maxWindow)
+	ra := s.readAhead
+	defer ra.invalidate()
+
+	const size = 128 << 10
+	data := make([]byte, size)
+	offset := 0
+	for _, window := range []int{minReadAheadWindowSize, 4 * readAheadBlockSize, maxWindow, maxWindow} {
+		_, err := ra.read(data, offset, size, proto.StorageClass_Replica_HDD)
+		require.NoError(t, err)
+		require.Equal(t, window, ra.window)
+		offset += size
+	}
+	waitReadAhead(ra)
+
+	// a random read resets the window and drops the blocks out of reach
+	offset = 40 * readAheadBlockSize
+	_, err := ra.read(data, offset, size, proto.StorageClass_Replica_HDD)
+	require.NoError(t, err)
+	require.Equal(t, 0, ra.window)
+	ra.Lock()
+	for blkOff := range ra.blocks {
+		require.True(t, blkOff+readAheadBlockSize > offset && blkOff < offset+size+maxWindow)
+	}
+	ra.Unlock()
+
+	// and sequential reads grow it again
+	_, err = ra.read(data, offset+size, size, proto.StorageClass_Replica_HDD)
+	require.NoError(t, err)
+	require.Equal(t, minReadAheadWindowSize, ra.window)
+}
+
+func TestReadAheadHit(t *testing.T) {
+	const fileSize = 4*readAheadBlockSize + 100
+	s, f := newReadAheadStreamer(fileSize, 4*readAheadBlockSize)
+	ra := s.readAhead
+	defer ra.invalidate()
+	for i := range f.data {
+		f.data[i] = byte(i % 251)
+	}
+
+	const size = 64 << 10
+	data := make([]byte, size)
+	_, err := ra.read(data, 0, size, proto.StorageClass_Replica_HDD)
+	require.NoError(t, err)
+	require.Equal(t, f.data[:size], data)
+	require.EqualValues(t, 1, f.misses)
+
+	// the following reads are served from the prefetched blocks, up to the
+	// end of file
+	offset := size
+	for {
+		waitReadAhead(ra)
+		n, err := ra.read(data, offset, size, proto.StorageClass_Replica_HDD)
+		require.Equal(t, f.data[offset:offset+n], data[:n])
+		offset += n
+		if err == io.EOF {
+			break
+		}
+		require.NoError(t, err)
+		require.Equal(t, size, n)
+	}
+	require.Equal(t, fileSize, offset)
+	require.EqualValues(t, 1, f.misses)
+	require.EqualValues(t, 5, f.loads)
+}
+
+func TestReadAheadInvalidate(t *testing.T) {
+	const size = 64 << 10
+	s, f := newReadAheadStreamer(8*readAheadBlockSize, 4*readAheadBlockSize)
+	ra := s.readAhead
+	defer ra.invalidate()
+	data := make([]byte, size)
+
+	read := func(offset int) {
+		_, err := ra.read(data, offset, size, proto.StorageClass_Replica_HDD)
+		require.NoError(t, err)
+		waitReadAhead(ra)
+	}
+	read(0)
+	read(size)
+	require.NotEmpty(t, ra.blocks)
+	require.Greater(t, ra.window, 0)
+
+	ra.invalidate()
+	require.Empty(t, ra.blocks)
+	require.Equal(t, 0, ra.window)
+	require.EqualValues(t, 0, atomic.LoadInt64(&s.client.readAheadMemUsed))
+
+	// a truncate drops the blocks loaded before it
+	read(0)
+	f.fill('t')
+	req := &TruncRequest{size: 4 * readAheadBlockSize, done: make(chan struct{}, 1)}
+	s.handleRequest(req)
+	require.NoError(t, req.err)
+	require.Empty(t, ra.blocks)
+	_, err := ra.read(data, size, size, proto.StorageClass_Replica_HDD)
+	require.NoError(t, err)
+	require.Equal(t, bytes.Repeat([]byte{'t'}, size), data)
+}
+
+// TestReadAheadReadDuringTruncate reads the file while it's modified, the
+// blocks loaded meanwhile must not be served after the modification.
+func TestReadAheadReadDuringTruncate(t *testing.T) {
+	const size = 64 << 10
+	s, f := newReadAheadStreamer(8*readAheadBlockSize, 4*readAheadBlockSize)
+	ra := s.readAhead
+	defer ra.invalidate()
+
+	started := make(chan struct{})
+	proceed := make(chan struct{})
+	s.client.truncate = func(inode, size uint64, fullPath string) error {
+		close(started)
+		<-proceed
+		f.fill('t')
+		return nil
+	}
+	req := &TruncRequest{size: 4 * readAheadBlockSize, done: make(chan struct{}, 1)}
+	go s.handleRequest(req)
+	<-started
+
+	data := make([]byte, size)
+	_, err := ra.read(data, 0, size, proto.StorageClass_Replica_HDD)
+	require.NoError(t, err)
+	waitReadAhead(ra)
+	require.NotEmpty(t, ra.blocks)
+
+	close(proceed)
+	<-req.done
+	require.NoError(t, req.err)
+
+	_, err = ra.read(data, size, size, proto.StorageClass_Replica_HDD)
+	require.NoError(t, err)
+	require.Equal(t, bytes.Repeat([]byte{'t'}, size), data)
+}
@@ -56,6 +56,7 @@ type Streamer struct {
 	needUpdateVer        int32
 	isCache              bool
 	openForWrite         bool
+	readAhead            *readAhead // nil if readahead is disabled
 
 	rdonly bool
 }
@@ -82,6 +83,9 @@ func NewStreamer(client *ExtentClient, inode uint64, openForWrite, isCache bool)
 	s.extents.verSeq = client.multiVerMgr.latestVerSeq
 	s.openForWrite = openForWrite
 	s.isCache = isCache
+	if client.readAheadMemLimit > 0 {
+		s.readAhead = newReadAhead(s)
+	}
 	log.LogDebugf("NewStreamer: streamer(%v)", s)
 	if s.openForWrite {
 		err := s.client.forbiddenMigration(s.inode)
@@ -143,6 +147,8 @@ func (s *Streamer) GetExtentReader(ek *proto.ExtentKey, storageClass uint32) (*E
 	enableFollowerRead := s.client.dataWrapper.FollowerRead() && !s.client.InnerReq
 	reader := NewExtentReader(s.inode, ek, partition, enableFollowerRead, retryRead)
 	reader.maxRetryTimeout = s.client.streamRetryTimeout
+	reader.pipelines = s.client.readPipelines
+	reader.hedge = s.client.hedgeRead
 	return reader, nil
 }
 
@@ -183,25 +189,33 @@ func (s *Streamer) read(data []byte, offset int, size int, storageClass uint32)
 
 	filesize, _ := s.extents.Size()
 	log.LogDebugf("read: ino(%v) requests(%v) filesize(%v)", s.inode, requests, filesize)
+
+	// Holes and block cache hits are served inline, the requests to data
+	// nodes are collected and issued concurrently. results keeps the outcome
+	// of each request in file order, so that short reads and errors still
+	// cut the returned size at the first incomplete request.
+	results := make([]extentReadResult, 0, len(requests))
+	var tasks []extentReadTask
 	for _, req := range requests {
 		log.LogDebugf("action[streamer.read] req %v", req)
 		if req.ExtentKey == nil {
-			zeros := make([]byte, len(req.Data))
-			copy(req.Data, zeros)
+			for i := range req.Data {
+				req.Data[i] = 0
+			}
 
 			if req.FileOffset+req.Size > filesize {
 				if req.FileOffset > filesize {
-					return
+					results = append(results, extentReadResult{stop: true})
+					break
 				}
 				req.Size = filesize - req.FileOffset
-				total += req.Size
-				err = io.EOF
-				return
+				results = append(results, extentReadResult{readBytes: req.Size, err: io.EOF, stop: true})
+				break
 			}
 
 			// Reading a hole, just fill zero
-			total += req.Size
-			log.LogDebugf("Stream read hole: ino(%v) req(%v) total(%v)", s.inode, req, total)
+			results = append(results, extentReadResult{readBytes: req.Size})
+			log.LogDebugf("Stream read hole: ino(%v) req(%v)", s.inode, req)
 		} else {
 			log.LogDebugf("Stream read: ino(%v) req(%v) s.needBCache(%v) s.client.bcacheEnable(%v)", s.inode, req, s.needBCache, s.client.bcacheEnable)
 			if s.needBCache {
@@ -226,7 +240,7 @@ func (s *Streamer) read(data []byte, offset int, size int, storageClass uint32)
 					if s.client.loadBcache != nil {
 						readBytes, err = s.client.loadBcache(cacheKey, req.Data, uint64(offset), uint32(req.Size))
 						if err == nil && readBytes == req.Size {
-							total += req.Size
+							results = append(results, extentReadResult{readBytes: req.Size})
 							bcacheMetric := exporter.NewCounter("fileReadL1CacheHit")
 							bcacheMetric.AddWithLabels(1, map[string]string{exporter.Vol: s.client.volumeName})
 							log.LogDebugf("TRACE Stream read. hit blockCache: ino(%v) storageClass(%v) cacheKey(%v) readBytes(%v) err(%v)",
@@ -251,6 +265,7 @@ func (s *Streamer) read(data []byte, offset int, size int, storageClass uint32)
 			reader, err = s.GetExtentReader(req.ExtentKey, storageClass)
 			if err != nil {
 				log.LogErrorf("action[streamer.read] req %v err %v", req, err)
+				results = append(results, extentReadResult{err: err, stop: true})
 				break
 			}
 
@@ -275,21 +290,80 @@ func (s *Streamer) read(data []byte, offset int, size int, storageClass uint32)
 				}
 			}
 
-			readBytes, err = reader.Read(req)
-			log.LogDebugf("TRACE Stream read: ino(%v) req(%v) readBytes(%v) err(%v)", s.inode, req, readBytes, err)
+			tasks = append(tasks, extentReadTask{reader: reader, req: req, index: len(results)})
+			results = append(results, extentReadResult{})
+		}
+	}
 
-			total += readBytes
+	s.readExtents(tasks, results)
 
-			if err != nil || readBytes < req.Size {
-				if total == 0 {
-					log.LogErrorf("Stream read: ino(%v) req(%v) readBytes(%v) err(%v)", s.inode, req, readBytes, err)
-				}
-				break
+	total, err = s.readTotal(requests, results)
+	log.LogDebugf("action[streamer.read] offset %v size %v exit", offset, size)
+	return
+}
+
+// readTotal returns the bytes read by the requests up to the first
+// incomplete one, and its error.
+func (s *Streamer) readTotal(requests []*ExtentRequest, results []extentReadResult) (total int, err error) {
+	for i, result := range results {
+		total += result.readBytes
+		if result.stop {
+			return total, result.err
+		}
+		if result.err != nil || result.readBytes < requests[i].Size {
+			if total == 0 {
+				log.LogErrorf("Stream read: ino(%v) req(%v) readBytes(%v) err(%v)", s.inode, requests[i], result.readBytes, result.err)
 			}
+			return total, result.err
 		}
 	}
-	log.LogDebugf("action[streamer.read] offset %v size %v exit", offset, size)
-	return
+	return total, nil
+}
+
+// max number of extent reads issued concurrently by one read request
+const maxExtentReadParallel = 8
+
+type extentReadTask struct {
+	reader *ExtentReader
+	req    *ExtentRequest
+	index  int // index of the result
+}
+
+type extentReadResult struct {
+	readBytes int
+	err       error
+	stop      bool // no request after this one is issued
+}
+
+// readExtents issues the extent reads concurrently, at most
+// maxExtentReadParallel at a time, and waits for all of them.
+func (s *Streamer) readExtents(tasks []extentReadTask, results []extentReadResult) {
+	doRead := func(task extentReadTask) {
+		readBytes, err := task.reader.Read(task.req)
+		log.LogDebugf("TRACE Stream read: ino(%v) req(%v) readBytes(%v) err(%v)", s.inode, task.req, readBytes, err)
+		results[task.index].readBytes = readBytes
+		results[task.index].err = err
+	}
+
+	if len(tasks) == 1 {
+		doRead(tasks[0])
+		return
+	}
+
+	var wg sync.WaitGroup
+	limit := make(chan struct{}, maxExtentReadParallel)
+	for _, task := range tasks {
+		wg.Add(1)
+		limit <- struct{}{}
+		go func(task extentReadTask) {
+			defer func() {
+				<-limit
+				wg.Done()
+			}()
+			doRead(task)
+		}(task)
+	}
+	wg.Wait()
 }
 
 func (s *Streamer) asyncBlockCache() {
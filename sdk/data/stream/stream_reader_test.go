@@ -0,0 +1,133 @@
+// Copyright 2024 The CubeFS Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+
+package stream
+
+import (
+	"io"
+	"sync/atomic"
+	"syscall"
+	"testing"
+
+	"github.com/cubefs/cubefs/proto"
+	"github.com/cubefs/cubefs/sdk/data/wrapper"
+	"github.com/stretchr/testify/require"
+)
+
+// newExtentReadTasks returns the tasks reading the extents 1 to n of a
+// partition on dn, the task i reads size(i) bytes at offset i*1000.
+func newExtentReadTasks(dn *fakeDataNode, n int, size func(i int) int) []extentReadTask {
+	dp := &wrapper.DataPartition{ClientWrapper: &wrapper.Wrapper{HostsStatus: map[string]bool{dn.addr(): true}}}
+	dp.PartitionID = 1
+	dp.Hosts = []string{dn.addr()}
+	dp.LeaderAddr = dn.addr()
+	tasks := make([]extentReadTask, n)
+	for i := range tasks {
+		key := &proto.ExtentKey{PartitionId: 1, ExtentId: uint64(i + 1), Size: 1 << 20}
+		req := NewExtentRequest(i*1000, size(i), make([]byte, size(i)), key)
+		tasks[i] = extentReadTask{reader: NewExtentReader(1, key, dp, false, false), req: req, index: i}
+	}
+	return tasks
+}
+
+func TestReadExtents(t *testing.T) {
+	dn := newFakeDataNode(t, false)
+	s := &Streamer{inode: 1}
+
+	// more tasks than maxExtentReadParallel, of different sizes, each result
+	// is stored at the index of its task
+	const n = 3*maxExtentReadParallel + 1
+	size := func(i int) int { return 4096 + (n-i)*10000 }
+	tasks := newExtentReadTasks(dn, n, size)
+	results := make([]extentReadResult, n)
+	s.readExtents(tasks, results)
+	for i, result := range results {
+		require.NoError(t, result.err, "task %v", i)
+		require.Equal(t, size(i), result.readBytes, "task %v", i)
+		checkExtentData(t, uint64(i+1), i*1000, tasks[i].req.Data)
+	}
+	require.EqualValues(t, n, atomic.LoadInt64(&dn.reads))
+
+	// the failure of an extent is reported in its result only
+	atomic.StoreUint64(&dn.failExtent, 5)
+	tasks = newExtentReadTasks(dn, n, size)
+	results = make([]extentReadResult, n)
+	s.readExtents(tasks, results)
+	for i, result := range results {
+		if i == 4 {
+			require.Error(t, result.err)
+			continue
+		}
+		require.NoError(t, result.err, "task %v", i)
+		require.Equal(t, size(i), result.readBytes, "task %v", i)
+		checkExtentData(t, uint64(i+1), i*1000, tasks[i].req.Data)
+	}
+
+	// and a single task is read inline
+	tasks = newExtentReadTasks(dn, 5, size)[4:]
+	tasks[0].index = 0
+	results = make([]extentReadResult, 1)
+	s.readExtents(tasks, results)
+	require.Error(t, results[0].err)
+	atomic.StoreUint64(&dn.failExtent, 0)
+	s.readExtents(tasks, results)
+	require.NoError(t, results[0].err)
+	require.Equal(t, size(4), results[0].readBytes)
+}
+
+func TestReadTotal(t *testing.T) {
+	s := &Streamer{inode: 1}
+	requests := []*ExtentRequest{{Size: 100}, {Size: 200}, {Size: 300}}
+	tests := []struct {
+		name    string
+		results []extentReadResult
+		total   int
+		err     error
+	}{
+		{
+			name:    "complete",
+			results: []extentReadResult{{readBytes: 100}, {readBytes: 200}, {readBytes: 300}},
+			total:   600,
+		},
+		{
+			name:    "failed in the middle",
+			results: []extentReadResult{{readBytes: 100}, {readBytes: 50, err: syscall.EIO}, {readBytes: 300}},
+			total:   150,
+			err:     syscall.EIO,
+		},
+		{
+			name:    "failed first",
+			results: []extentReadResult{{err: syscall.EIO}, {readBytes: 200}, {readBytes: 300}},
+			err:     syscall.EIO,
+		},
+		{
+			name:    "short read",
+			results: []extentReadResult{{readBytes: 100}, {readBytes: 20}, {readBytes: 300}},
+			total:   120,
+		},
+		{
+			name:    "end of file",
+			results: []extentReadResult{{readBytes: 100}, {readBytes: 80, err: io.EOF, stop: true}},
+			total:   180,
+			err:     io.EOF,
+		},
+	}
+	for _, tt := range tests {
+		t.Run(tt.name, func(t *testing.T) {
+			total, err := s.readTotal(requests, tt.results)
+			require.Equal(t, tt.total, total)
+			require.Equal(t, tt.err, err)
+		})
+	}
+}
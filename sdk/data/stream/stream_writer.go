@@ -305,14 +305,17 @@ func (s *Streamer) handleRequest(request interface{}) {
 	case *WriteRequest:
 		request.writeBytes, request.err = s.write(request.data, request.fileOffset, request.size, request.flags,
 			request.checkFunc, request.storageClass, request.isMigration)
+		s.invalidateReadAhead()
 		request.done <- struct{}{}
 	case *TruncRequest:
 		request.err = s.truncate(request.size, request.fullPath)
+		s.invalidateReadAhead()
 		request.done <- struct{}{}
 	case *FlushRequest:
 		request.err = s.flush()
 		request.done <- struct{}{}
 	case *ReleaseRequest:
+		s.invalidateReadAhead()
 		request.err = s.release()
 		request.done <- struct{}{}
 	case *EvictRequest:
@@ -1100,6 +1103,12 @@ func (s *Streamer) updateVer(verSeq uint64) (err error) {
 	return
 }
 
+func (s *Streamer) invalidateReadAhead() {
+	if s.readAhead != nil {
+		s.readAhead.invalidate()
+	}
+}
+
 func (s *Streamer) tinySizeLimit() int {
 	return util.DefaultTinySizeLimit
 }
@@ -90,7 +90,7 @@ func (mw *MetaWrapper) LookupPath(subdir string) (uint64, error) {
 		if dir == "/" || dir == "" {
 			continue
 		}
-		child, _, err := mw.Lookup_ll(ino, dir)
+		child, err := mw.lookupPathComponent(ino, dir)
 		if err != nil {
 			return 0, err
 		}
@@ -99,6 +99,25 @@ func (mw *MetaWrapper) LookupPath(subdir string) (uint64, error) {
 	return ino, nil
 }
 
+func (mw *MetaWrapper) lookupPathComponent(parentID uint64, name string) (uint64, error) {
+	if mw.pathCache == nil {
+		child, _, err := mw.Lookup_ll(parentID, name)
+		return child, err
+	}
+	return mw.pathCache.lookup(parentID, name, func() (uint64, uint32, error) {
+		return mw.Lookup_ll(parentID, name)
+	})
+}
+
+// invalidatePathCacheDentry drops name in parentID from the cache of
+// LookupPath. It's called once a request modifying the dentry returns, a
+// lookup could cache the old dentry again until then.
+func (mw *MetaWrapper) invalidatePathCacheDentry(parentID uint64, name string) {
+	if mw.pathCache != nil {
+		mw.pathCache.InvalidateDentry(parentID, name)
+	}
+}
+
 func (mw *MetaWrapper) Statfs() (total, used, inodeCount uint64) {
 	total = atomic.LoadUint64(&mw.totalSize)
 	used = atomic.LoadUint64(&mw.usedSize)
@@ -497,6 +516,61 @@ func (mw *MetaWrapper) BatchInodeGet(inodes []uint64) []*proto.InodeInfo {
 	return batchInfos
 }
 
+// BatchInodeGetInto fetches the inodes with one request per meta partition,
+// like BatchInodeGet, and stores the info of inodes[i] in infos[i], which is
+// left nil if the inode is not found.
+func (mw *MetaWrapper) BatchInodeGetInto(inodes []uint64, infos []*proto.InodeInfo) {
+	var wg sync.WaitGroup
+
+	// indexes of the inodes of each partition
+	candidates := make(map[uint64][]int)
+	for i, ino := range inodes {
+		mp := mw.getPartitionByInode(ino)
+		if mp == nil {
+			continue
+		}
+		candidates[mp.PartitionID] = append(candidates[mp.PartitionID], i)
+	}
+
+	for id, idxs := range candidates {
+		mp := mw.getPartitionByID(id)
+		if mp == nil {
+			continue
+		}
+		wg.Add(1)
+		go func(mp *MetaPartition, idxs []int) {
+			defer wg.Done()
+			sort.Slice(idxs, func(i, j int) bool { return inodes[idxs[i]] < inodes[idxs[j]] })
+			inos := make([]uint64, len(idxs))
+			for i, idx := range idxs {
+				inos[i] = inodes[idx]
+			}
+
+			var iwg sync.WaitGroup
+			resp := make(chan []*proto.InodeInfo, 1)
+			iwg.Add(1)
+			mw.batchIget(&iwg, mp, inos, resp)
+			close(resp)
+			got := <-resp
+			sort.Slice(got, func(i, j int) bool { return got[i].Inode < got[j].Inode })
+
+			// both sorted by inode, the same inode may be asked several times
+			j := 0
+			for _, idx := range idxs {
+				for j < len(got) && got[j].Inode < inodes[idx] {
+					j++
+				}
+				if j < len(got) && got[j].Inode == inodes[idx] {
+					infos[idx] = got[j]
+				}
+			}
+		}(mp, idxs)
+	}
+	wg.Wait()
+
+	log.LogDebugf("BatchInodeGetInto: inodesCnt(%d)", len(inodes))
+}
+
 // InodeDelete_ll is a low-level api that removes specified inode immediately
 // and do not effect extent data managed by this inode.
 func (mw *MetaWrapper) InodeDelete_ll(inode uint64, fullPath string) error {
@@ -660,6 +734,7 @@ func (mw *MetaWrapper) Delete_ll(parentID uint64, name string, isDir bool, fullP
 }
 
 func (mw *MetaWrapper) DeleteWithCond_ll(parentID, cond uint64, name string, isDir bool, fullPath string) (*proto.InodeInfo, error) {
+	defer mw.invalidatePathCacheDentry(parentID, name)
 	return mw.deletewithcond_ll(parentID, cond, name, isDir, fullPath)
 }
 
@@ -672,6 +747,7 @@ func (mw *MetaWrapper) Delete_Ver_ll(parentID uint64, name string, isDir bool, v
 }
 
 func (mw *MetaWrapper) txDelete_ll(parentID uint64, name string, isDir bool, fullPath string) (info *proto.InodeInfo, err error) {
+	defer mw.invalidatePathCacheDentry(parentID, name)
 	var (
 		status int
 		inode  uint64
@@ -829,6 +905,7 @@ func (mw *MetaWrapper) txDelete_ll(parentID uint64, name string, isDir bool, ful
  */
 
 func (mw *MetaWrapper) Delete_ll_EX(parentID uint64, name string, isDir bool, verSeq uint64, fullPath string) (*proto.InodeInfo, error) {
+	defer mw.invalidatePathCacheDentry(parentID, name)
 	var (
 		status          int
 		inode           uint64
@@ -1112,6 +1189,10 @@ func (mw *MetaWrapper) deletewithcond_ll(parentID, cond uint64, name string, isD
 }
 
 func (mw *MetaWrapper) Rename_ll(srcParentID uint64, srcName string, dstParentID uint64, dstName string, srcFullPath string, dstFullPath string, overwritten bool) (err error) {
+	defer func() {
+		mw.invalidatePathCacheDentry(srcParentID, srcName)
+		mw.invalidatePathCacheDentry(dstParentID, dstName)
+	}()
 	if mw.enableTx(proto.TxOpMaskRename) {
 		return mw.txRename_ll(srcParentID, srcName, dstParentID, dstName, srcFullPath, dstFullPath, overwritten)
 	} else {
@@ -0,0 +1,152 @@
+// Copyright 2024 The CubeFS Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+
+package meta
+
+import (
+	"encoding/json"
+	"net"
+	"sync"
+	"sync/atomic"
+	"testing"
+
+	"github.com/cubefs/cubefs/proto"
+	"github.com/cubefs/cubefs/util"
+	"github.com/cubefs/cubefs/util/btree"
+	"github.com/stretchr/testify/assert"
+	"github.com/stretchr/testify/require"
+)
+
+var initBufferPoolOnce sync.Once
+
+// fakeMetaNode serves the batch inode gets of the meta partitions of a test
+// wrapper. The requests to the partitions in failing are answered with an
+// error.
+type fakeMetaNode struct {
+	ln       net.Listener
+	inodes   map[uint64]bool
+	failing  sync.Map // partition id to true
+	requests int64
+}
+
+func newFakeMetaNode(t *testing.T, inodes []uint64) *fakeMetaNode {
+	initBufferPoolOnce.Do(func() { proto.InitBufferPool(0) })
+	ln, err := net.Listen("tcp", "127.0.0.1:0")
+	require.NoError(t, err)
+	mn := &fakeMetaNode{
+		ln:     ln,
+		inodes: make(map[uint64]bool),
+	}
+	for _, ino := range inodes {
+		mn.inodes[ino] = true
+	}
+	go func() {
+		for {
+			conn, err := ln.Accept()
+			if err != nil {
+				return
+			}
+			go mn.serve(conn)
+		}
+	}()
+	t.Cleanup(func() { ln.Close() })
+	return mn
+}
+
+func (mn *fakeMetaNode) serve(conn net.Conn) {
+	defer conn.Close()
+	for {
+		p := proto.NewPacket()
+		if err := p.ReadFromConnWithVer(conn, proto.NoReadDeadlineTime); err != nil {
+			return
+		}
+		atomic.AddInt64(&mn.requests, 1)
+		req := new(proto.BatchInodeGetRequest)
+		if p.Opcode != proto.OpMetaBatchInodeGet || json.Unmarshal(p.Data, req) != nil {
+			p.PacketErrorWithBody(proto.OpArgMismatchErr, nil)
+		} else if _, ok := mn.failing.Load(p.PartitionID); ok {
+			p.PacketErrorWithBody(proto.OpNotExistErr, []byte("partition not found"))
+		} else {
+			resp := new(proto.BatchInodeGetResponse)
+			for _, ino := range req.Inodes {
+				if mn.inodes[ino] {
+					resp.Infos = append(resp.Infos, &proto.InodeInfo{Inode: ino, Mode: 0o644, Size: ino})
+				}
+			}
+			reply, _ := json.Marshal(resp)
+			p.PacketOkWithBody(reply)
+		}
+		if err := p.WriteToConn(conn); err != nil {
+			return
+		}
+	}
+}
+
+// newFakeMetaWrapper returns a wrapper of the meta partitions [1, 100],
+// [101, 200] and [201, 300], served by mn.
+func newFakeMetaWrapper(mn *fakeMetaNode) *MetaWrapper {
+	mw := &MetaWrapper{
+		volname:    "test",
+		conns:      util.NewConnectPool(),
+		partitions: make(map[uint64]*MetaPartition),
+		ranges:     btree.New(32),
+	}
+	addr := mn.ln.Addr().String()
+	for id := uint64(1); id <= 3; id++ {
+		mw.addPartition(&MetaPartition{
+			PartitionID: id,
+			Start:       (id-1)*100 + 1,
+			End:         id * 100,
+			LeaderAddr:  addr,
+			Members:     []string{addr},
+		})
+	}
+	return mw
+}
+
+func TestBatchInodeGetInto(t *testing.T) {
+	mn := newFakeMetaNode(t, []uint64{3, 5, 42, 150, 160, 250})
+	mw := newFakeMetaWrapper(mn)
+	defer mw.conns.Close()
+
+	// the infos are stored in the order of the inodes, the duplicated
+	// inodes are filled too
+	inodes := []uint64{160, 5, 250, 3, 5, 150, 42}
+	infos := make([]*proto.InodeInfo, len(inodes))
+	mw.BatchInodeGetInto(inodes, infos)
+	for i, ino := range inodes {
+		require.NotNil(t, infos[i], "inode %v", ino)
+		assert.Equal(t, ino, infos[i].Inode)
+	}
+	// one request per partition
+	assert.EqualValues(t, 3, atomic.LoadInt64(&mn.requests))
+
+	// the missing inodes, the ones out of any partition and the ones of a
+	// failed partition are left nil
+	mn.failing.Store(uint64(2), true)
+	inodes = []uint64{5, 150, 4, 1000, 250, 160, 42}
+	infos = make([]*proto.InodeInfo, len(inodes))
+	mw.BatchInodeGetInto(inodes, infos)
+	for i, ino := range inodes {
+		switch ino {
+		case 5, 250, 42:
+			require.NotNil(t, infos[i], "inode %v", ino)
+			assert.Equal(t, ino, infos[i].Inode)
+		default:
+			assert.Nil(t, infos[i], "inode %v", ino)
+		}
+	}
+
+	mw.BatchInodeGetInto(nil, nil)
+}
@@ -103,6 +103,10 @@ type MetaConfig struct {
 	VerReadSeq           uint64
 	InnerReq             bool
 	DisableTrashByClient bool
+
+	// the directories resolved by LookupPath are cached if PathCacheExpiration is positive
+	PathCacheExpiration time.Duration
+	PathCacheMaxEntries int
 }
 
 type MetaWrapper struct {
@@ -179,6 +183,7 @@ type MetaWrapper struct {
 	disableTrash  bool
 	rootIno       uint64
 	dirCache      map[uint64]dirInfoCache
+	pathCache     *PathCache // nil if disabled
 	inoInfoLk     sync.RWMutex
 	subDir        string
 
@@ -257,6 +262,13 @@ func NewMetaWrapper(config *MetaConfig) (*MetaWrapper, error) {
 	mw.DefaultStorageClass = proto.StorageClass_Unspecified
 	mw.InnerReq = config.InnerReq
 	mw.disableTrashByClient = config.DisableTrashByClient
+	if config.PathCacheExpiration > 0 {
+		maxEntries := DefaultMaxPathCache
+		if config.PathCacheMaxEntries > 0 {
+			maxEntries = config.PathCacheMaxEntries
+		}
+		mw.pathCache = NewPathCache(config.PathCacheExpiration, maxEntries)
+	}
 
 	for limit > 0 {
 		err = mw.initMetaWrapper()
@@ -0,0 +1,214 @@
+// Copyright 2024 The CubeFS Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+
+package meta
+
+import (
+	"strconv"
+	"sync"
+	"time"
+
+	"github.com/cubefs/cubefs/proto"
+	"golang.org/x/sync/singleflight"
+)
+
+const DefaultMaxPathCache = 1000000
+
+type pathCacheNode struct {
+	ino      uint64
+	name     string
+	parent   *pathCacheNode
+	expire   int64
+	children map[string]*pathCacheNode
+}
+
+// PathCache caches the directories resolved by LookupPath as a trie of path
+// components rooted at the root inode, so that the ancestors resolved for a
+// path are reused by every other path below them. Directories have a single
+// parent, so each node is also indexed by inode, which allows dropping a
+// directory with everything cached below it. Concurrent lookups of the same
+// component are coalesced into a single request.
+type PathCache struct {
+	sync.RWMutex
+	root       *pathCacheNode
+	nodes      map[uint64]*pathCacheNode
+	expiration time.Duration
+	maxEntries int
+	group      singleflight.Group
+	// invalidations counts the invalidations, a lookup does not cache its
+	// result if the cache was invalidated while it was in progress
+	invalidations uint64
+	now           func() time.Time
+}
+
+func NewPathCache(exp time.Duration, maxEntries int) *PathCache {
+	pc := &PathCache{
+		expiration: exp,
+		maxEntries: maxEntries,
+		now:        time.Now,
+	}
+	pc.reset()
+	return pc
+}
+
+func (pc *PathCache) reset() {
+	pc.root = &pathCacheNode{ino: proto.RootIno, expire: -1, children: make(map[string]*pathCacheNode)}
+	pc.nodes = map[uint64]*pathCacheNode{proto.RootIno: pc.root}
+}
+
+// Get returns the inode of the directory name in parentID.
+func (pc *PathCache) Get(parentID uint64, name string) (uint64, bool) {
+	pc.RLock()
+	defer pc.RUnlock()
+	parent, ok := pc.nodes[parentID]
+	if !ok {
+		return 0, false
+	}
+	child, ok := parent.children[name]
+	if !ok || pc.now().UnixNano() > child.expire {
+		return 0, false
+	}
+	return child.ino, true
+}
+
+// Put caches the directory name in parentID, if parentID is cached itself.
+func (pc *PathCache) Put(parentID uint64, name string, ino uint64) {
+	pc.Lock()
+	defer pc.Unlock()
+	pc.put(parentID, name, ino)
+}
+
+func (pc *PathCache) put(parentID uint64, name string, ino uint64) {
+	parent, ok := pc.nodes[parentID]
+	if !ok {
+		return
+	}
+	if old, ok := parent.children[name]; ok {
+		pc.remove(old)
+	}
+	if old, ok := pc.nodes[ino]; ok {
+		// the directory was moved
+		pc.remove(old)
+	}
+	if len(pc.nodes) >= pc.maxEntries {
+		pc.reset()
+		if parent = pc.nodes[parentID]; parent == nil {
+			return
+		}
+	}
+	child := &pathCacheNode{
+		ino:      ino,
+		name:     name,
+		parent:   parent,
+		expire:   pc.now().Add(pc.expiration).UnixNano(),
+		children: make(map[string]*pathCacheNode),
+	}
+	parent.children[name] = child
+	pc.nodes[ino] = child
+}
+
+// InvalidateDentry drops the directory name in parentID and everything
+// cached below it.
+func (pc *PathCache) InvalidateDentry(parentID uint64, name string) {
+	// the lookups started from now on don't join the ones in progress
+	pc.group.Forget(pathLookupKey(parentID, name))
+	pc.Lock()
+	defer pc.Unlock()
+	pc.invalidations++
+	if parent, ok := pc.nodes[parentID]; ok {
+		if child, ok := parent.children[name]; ok {
+			pc.remove(child)
+		}
+	}
+}
+
+// InvalidateDir drops the directory ino and everything cached below it.
+func (pc *PathCache) InvalidateDir(ino uint64) {
+	pc.Lock()
+	defer pc.Unlock()
+	pc.invalidations++
+	if ino == proto.RootIno {
+		pc.reset()
+		return
+	}
+	if node, ok := pc.nodes[ino]; ok {
+		pc.remove(node)
+	}
+}
+
+// remove unlinks node from its parent and drops its subtree, it must be
+// called with the lock held.
+func (pc *PathCache) remove(node *pathCacheNode) {
+	if node.parent != nil {
+		delete(node.parent.children, node.name)
+		node.parent = nil
+	}
+	pc.drop(node)
+}
+
+func (pc *PathCache) drop(node *pathCacheNode) {
+	for _, child := range node.children {
+		pc.drop(child)
+	}
+	if pc.nodes[node.ino] == node {
+		delete(pc.nodes, node.ino)
+	}
+}
+
+func (pc *PathCache) Len() int {
+	pc.RLock()
+	defer pc.RUnlock()
+	return len(pc.nodes) - 1
+}
+
+type pathLookupResult struct {
+	ino  uint64
+	mode uint32
+}
+
+// lookup resolves name in parentID with lookupFn on a cache miss, the
+// concurrent misses of the same component share a single lookupFn call.
+// Only directories are cached.
+func (pc *PathCache) lookup(parentID uint64, name string, lookupFn func() (uint64, uint32, error)) (uint64, error) {
+	if ino, ok := pc.Get(parentID, name); ok {
+		return ino, nil
+	}
+	v, err, _ := pc.group.Do(pathLookupKey(parentID, name), func() (interface{}, error) {
+		pc.RLock()
+		invalidations := pc.invalidations
+		pc.RUnlock()
+		ino, mode, err := lookupFn()
+		if err != nil {
+			return nil, err
+		}
+		if proto.IsDir(mode) {
+			// the result may predate a rename or delete which invalidated
+			// the cache meanwhile
+			pc.Lock()
+			if pc.invalidations == invalidations {
+				pc.put(parentID, name, ino)
+			}
+			pc.Unlock()
+		}
+		return pathLookupResult{ino: ino, mode: mode}, nil
+	})
+	if err != nil {
+		return 0, err
+	}
+	return v.(pathLookupResult).ino, nil
+}
+
+func pathLookupKey(parentID uint64, name string) string {
+	return strconv.FormatUint(parentID, 10) + "/" + name
+}
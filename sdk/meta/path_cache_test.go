@@ -0,0 +1,161 @@
+// Copyright 2024 The CubeFS Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or
+// implied. See the License for the specific language governing
+// permissions and limitations under the License.
+
+package meta
+
+import (
+	"os"
+	"runtime"
+	"sync"
+	"sync/atomic"
+	"syscall"
+	"testing"
+	"time"
+
+	"github.com/cubefs/cubefs/proto"
+	"github.com/stretchr/testify/assert"
+)
+
+var dirMode = proto.Mode(os.ModeDir | 0o755)
+
+func TestPathCacheInvalidate(t *testing.T) {
+	pc := NewPathCache(time.Minute, DefaultMaxPathCache)
+	// /a(2)/b(3)/c(4), /a(2)/d(5)
+	pc.Put(proto.RootIno, "a", 2)
+	pc.Put(2, "b", 3)
+	pc.Put(3, "c", 4)
+	pc.Put(2, "d", 5)
+	// the parent is not cached
+	pc.Put(6, "e", 7)
+	assert.Equal(t, 4, pc.Len())
+
+	ino, ok := pc.Get(3, "c")
+	assert.True(t, ok)
+	assert.Equal(t, uint64(4), ino)
+
+	pc.InvalidateDir(3)
+	_, ok = pc.Get(2, "b")
+	assert.False(t, ok)
+	_, ok = pc.Get(3, "c")
+	assert.False(t, ok)
+	_, ok = pc.Get(2, "d")
+	assert.True(t, ok)
+
+	pc.InvalidateDentry(proto.RootIno, "a")
+	assert.Equal(t, 0, pc.Len())
+
+	// a moved directory is only cached at its new place
+	pc.Put(proto.RootIno, "a", 2)
+	pc.Put(2, "b", 3)
+	pc.Put(proto.RootIno, "b", 3)
+	_, ok = pc.Get(2, "b")
+	assert.False(t, ok)
+	ino, ok = pc.Get(proto.RootIno, "b")
+	assert.True(t, ok)
+	assert.Equal(t, uint64(3), ino)
+}
+
+func TestPathCacheExpiration(t *testing.T) {
+	pc := NewPathCache(time.Minute, DefaultMaxPathCache)
+	now := time.Now()
+	pc.now = func() time.Time { return now }
+	pc.Put(proto.RootIno, "a", 2)
+	now = now.Add(time.Minute)
+	_, ok := pc.Get(proto.RootIno, "a")
+	assert.True(t, ok)
+	now = now.Add(time.Nanosecond)
+	_, ok = pc.Get(proto.RootIno, "a")
+	assert.False(t, ok)
+
+	pc = NewPathCache(time.Minute, 3)
+	pc.Put(proto.RootIno, "a", 2)
+	pc.Put(proto.RootIno, "b", 3)
+	pc.Put(proto.RootIno, "c", 4)
+	assert.Equal(t, 1, pc.Len())
+}
+
+func TestPathCacheLookup(t *testing.T) {
+	pc := NewPathCache(time.Minute, DefaultMaxPathCache)
+	var calls int32
+	release := make(chan struct{})
+	lookupFn := func() (uint64, uint32, error) {
+		atomic.AddInt32(&calls, 1)
+		<-release
+		return 2, dirMode, nil
+	}
+
+	var wg sync.WaitGroup
+	for i := 0; i < 8; i++ {
+		wg.Add(1)
+		go func() {
+			defer wg.Done()
+			ino, err := pc.lookup(proto.RootIno, "a", lookupFn)
+			assert.NoError(t, err)
+			assert.Equal(t, uint64(2), ino)
+		}()
+	}
+	for atomic.LoadInt32(&calls) == 0 {
+		runtime.Gosched()
+	}
+	close(release)
+	wg.Wait()
+	assert.Equal(t, int32(1), atomic.LoadInt32(&calls))
+
+	// cached now
+	_, err := pc.lookup(proto.RootIno, "a", lookupFn)
+	assert.NoError(t, err)
+	assert.Equal(t, int32(1), atomic.LoadInt32(&calls))
+
+	// neither errors nor files are cached
+	_, err = pc.lookup(proto.RootIno, "x", func() (uint64, uint32, error) { return 0, 0, syscall.ENOENT })
+	assert.Equal(t, syscall.ENOENT, err)
+	_, err = pc.lookup(proto.RootIno, "f", func() (uint64, uint32, error) { return 3, proto.Mode(0o644), nil })
+	assert.NoError(t, err)
+	assert.Equal(t, 1, pc.Len())
+}
+
+// TestPathCacheInvalidateDuringLookup invalidates a dentry while it's looked
+// up, as a rename or delete does once its request returns.
+func TestPathCacheInvalidateDuringLookup(t *testing.T) {
+	pc := NewPathCache(time.Minute, DefaultMaxPathCache)
+	started := make(chan struct{})
+	release := make(chan struct{})
+	done := make(chan uint64)
+	go func() {
+		ino, err := pc.lookup(proto.RootIno, "a", func() (uint64, uint32, error) {
+			close(started)
+			<-release
+			return 2, dirMode, nil
+		})
+		assert.NoError(t, err)
+		done <- ino
+	}()
+	<-started
+	pc.InvalidateDentry(proto.RootIno, "a")
+
+	// a lookup issued after the invalidation does not join the one in
+	// progress
+	ino, err := pc.lookup(proto.RootIno, "a", func() (uint64, uint32, error) {
+		return 5, dirMode, nil
+	})
+	assert.NoError(t, err)
+	assert.Equal(t, uint64(5), ino)
+
+	// and the old result is not cached
+	pc.InvalidateDentry(proto.RootIno, "a")
+	close(release)
+	assert.Equal(t, uint64(2), <-done)
+	_, ok := pc.Get(proto.RootIno, "a")
+	assert.False(t, ok)
+}